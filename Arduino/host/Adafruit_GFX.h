@@ -0,0 +1,37 @@
+#pragma once
+
+// Host stand-in for the Adafruit GFX library: the drawing calls the kaptx View
+// uses, on a 1 bit frame buffer.  Text is not rendered, just remembered.
+
+#include <stdint.h>
+
+class Adafruit_GFX
+{
+  public:
+    Adafruit_GFX(int16_t w, int16_t h);
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+		      int16_t x2, int16_t y2, uint16_t color);
+    void drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+		     int16_t w, int16_t h, uint16_t color);
+
+    void setRotation(uint8_t r);
+    void setTextSize(uint8_t s);
+    void setTextColor(uint16_t c, uint16_t bg);
+    void setCursor(int16_t x, int16_t y);
+    void print(const char *s);
+
+    int16_t width() { return _width; }
+    int16_t height() { return _height; }
+
+    // last string printed, for the simulator
+    char text[32];
+
+  protected:
+    int16_t _width;
+    int16_t _height;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+// Host stand-in for the Adafruit Sharp Memory LCD driver.
+// refresh() costs simulated time, as the bit-banged transfer does on the AVR.
+
+#include <stdio.h>
+#include "Adafruit_GFX.h"
+
+#define SHARPMEM_LCDWIDTH (96)
+#define SHARPMEM_LCDHEIGHT (96)
+
+class Adafruit_SharpMem : public Adafruit_GFX
+{
+  public:
+    Adafruit_SharpMem(uint8_t clk, uint8_t mosi, uint8_t ss);
+
+    bool begin();
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    uint8_t getPixel(uint16_t x, uint16_t y);
+    void clearDisplay();
+    void refresh();
+
+    // Write the frame buffer as a PBM image.  (Host only.)
+    void dumpPbm(FILE *f);
+
+    unsigned long refreshes;
+
+  private:
+    uint8_t buffer[SHARPMEM_LCDWIDTH * SHARPMEM_LCDHEIGHT / 8];
+};
+
+// Simulated time one refresh() takes.  [uS]
+extern unsigned long hal_lcdRefreshUs;
@@ -0,0 +1,74 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core the kaptx sketch uses.
+// Time only passes inside the HAL (sleep_cpu(), analogRead(), display refresh);
+// see hal.h.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define F_CPU 16000000UL
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+
+// Analog pins, numbered as on the Uno
+#define A0 (14)
+#define A1 (15)
+#define A2 (16)
+#define A3 (17)
+#define A4 (18)
+#define A5 (19)
+
+#define NUM_DIGITAL_PINS (20)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+
+    void print(const char *s);
+    void print(const __FlashStringHelper *s);
+    void print(char c);
+    void print(int n, int base = DEC);
+    void print(unsigned n, int base = DEC);
+    void print(long n, int base = DEC);
+    void print(unsigned long n, int base = DEC);
+
+    void println();
+    template <class T> void println(T v) { print(v); println(); }
+    template <class T> void println(T v, int base) { print(v, base); println(); }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,179 @@
+// Host stand-ins for Adafruit_GFX and Adafruit_SharpMem.
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SharpMem.h>
+
+#include "hal.h"
+
+// Estimate of a full refresh over bit-banged SPI on a 16MHz AVR.
+unsigned long hal_lcdRefreshUs = 12000;
+
+// --------------------------------------------------------------------------------
+// Adafruit_GFX
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) :
+    _width(w),
+    _height(h)
+{
+    text[0] = '\0';
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t i = x; i < x + w; i++) {
+	drawPixel(i, y, color);
+	drawPixel(i, y + h - 1, color);
+    }
+    for (int16_t j = y; j < y + h; j++) {
+	drawPixel(x, j, color);
+	drawPixel(x + w - 1, j, color);
+    }
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t j = y; j < y + h; j++) {
+	for (int16_t i = x; i < x + w; i++) {
+	    drawPixel(i, j, color);
+	}
+    }
+}
+
+// Which side of edge (x0,y0)-(x1,y1) the point (x,y) is on.
+static long edge(long x0, long y0, long x1, long y1, long x, long y)
+{
+    return (x1 - x0) * (y - y0) - (y1 - y0) * (x - x0);
+}
+
+void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+				int16_t x2, int16_t y2, uint16_t color)
+{
+    int16_t xmin = x0, xmax = x0, ymin = y0, ymax = y0;
+    if (x1 < xmin) xmin = x1;
+    if (x2 < xmin) xmin = x2;
+    if (x1 > xmax) xmax = x1;
+    if (x2 > xmax) xmax = x2;
+    if (y1 < ymin) ymin = y1;
+    if (y2 < ymin) ymin = y2;
+    if (y1 > ymax) ymax = y1;
+    if (y2 > ymax) ymax = y2;
+
+    for (int16_t y = ymin; y <= ymax; y++) {
+	for (int16_t x = xmin; x <= xmax; x++) {
+	    long e0 = edge(x0, y0, x1, y1, x, y);
+	    long e1 = edge(x1, y1, x2, y2, x, y);
+	    long e2 = edge(x2, y2, x0, y0, x, y);
+	    if (((e0 >= 0) && (e1 >= 0) && (e2 >= 0)) ||
+		((e0 <= 0) && (e1 <= 0) && (e2 <= 0))) {
+		drawPixel(x, y, color);
+	    }
+	}
+    }
+}
+
+// XBM: rows padded to whole bytes, least significant bit leftmost.
+void Adafruit_GFX::drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+			       int16_t w, int16_t h, uint16_t color)
+{
+    int16_t byteWidth = (w + 7) / 8;
+
+    for (int16_t j = 0; j < h; j++) {
+	for (int16_t i = 0; i < w; i++) {
+	    uint8_t b = pgm_read_byte(bitmap + j * byteWidth + i / 8);
+	    if (b & (1 << (i & 7))) {
+		drawPixel(x + i, y + j, color);
+	    }
+	}
+    }
+}
+
+void Adafruit_GFX::setRotation(uint8_t r)
+{
+    (void)r;
+}
+
+void Adafruit_GFX::setTextSize(uint8_t s)
+{
+    (void)s;
+}
+
+void Adafruit_GFX::setTextColor(uint16_t c, uint16_t bg)
+{
+    (void)c;
+    (void)bg;
+}
+
+void Adafruit_GFX::setCursor(int16_t x, int16_t y)
+{
+    (void)x;
+    (void)y;
+}
+
+void Adafruit_GFX::print(const char *s)
+{
+    strncpy(text, s, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+}
+
+// --------------------------------------------------------------------------------
+// Adafruit_SharpMem
+
+Adafruit_SharpMem::Adafruit_SharpMem(uint8_t clk, uint8_t mosi, uint8_t ss) :
+    Adafruit_GFX(SHARPMEM_LCDWIDTH, SHARPMEM_LCDHEIGHT)
+{
+    (void)clk;
+    (void)mosi;
+    (void)ss;
+    refreshes = 0;
+    clearDisplay();
+}
+
+bool Adafruit_SharpMem::begin()
+{
+    return true;
+}
+
+// color 1 is white, as on the LCD; a set bit in the buffer is a white pixel.
+void Adafruit_SharpMem::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height)) return;
+
+    unsigned n = y * _width + x;
+    if (color) {
+	buffer[n / 8] |= (1 << (n & 7));
+    }
+    else {
+	buffer[n / 8] &= ~(1 << (n & 7));
+    }
+}
+
+uint8_t Adafruit_SharpMem::getPixel(uint16_t x, uint16_t y)
+{
+    if ((x >= (uint16_t)_width) || (y >= (uint16_t)_height)) return 0;
+
+    unsigned n = y * _width + x;
+    return (buffer[n / 8] >> (n & 7)) & 1;
+}
+
+void Adafruit_SharpMem::clearDisplay()
+{
+    memset(buffer, 0xff, sizeof(buffer));
+}
+
+void Adafruit_SharpMem::refresh()
+{
+    refreshes++;
+    hal_spendUs(hal_lcdRefreshUs);
+}
+
+void Adafruit_SharpMem::dumpPbm(FILE *f)
+{
+    fprintf(f, "P1\n%d %d\n", _width, _height);
+    for (int16_t y = 0; y < _height; y++) {
+	for (int16_t x = 0; x < _width; x++) {
+	    fputc(getPixel(x, y) ? '0' : '1', f);
+	}
+	fputc('\n', f);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Host stand-in for avr/interrupt.h.
+// An ISR is an ordinary function the HAL calls when its interrupt is due.
+
+#include <avr/io.h>
+
+#define TIMER2_COMPA_vect hal_vect_timer2_compa
+#define TIMER1_OVF_vect hal_vect_timer1_ovf
+#define ADC_vect hal_vect_adc
+#define PCINT0_vect hal_vect_pcint0
+
+#define ISR(vector) extern "C" void vector(void); void vector(void)
+
+// As on the AVR, sei() doesn't run pending interrupts by itself; they run at
+// the next point time passes (e.g. sleep_cpu()).
+static inline void sei() { SREG |= 0x80; }
+static inline void cli() { SREG &= ~0x80; }
@@ -0,0 +1,69 @@
+#pragma once
+
+// Host stand-in for the AVR I/O registers used by the kaptx sketch.
+// They are plain variables: the HAL reads what the sketch wrote whenever it
+// advances time, and updates counters and flags for the sketch to read.
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+extern volatile uint8_t SREG;
+
+// An interrupt flag register.  As on the AVR, writing a one to a flag clears it;
+// only the HAL sets flags, with set().
+class HalFlags
+{
+  public:
+    operator uint8_t() const { return bits; }
+    HalFlags &operator=(uint8_t b) { bits &= ~b; return *this; }
+    void set(uint8_t b) { bits |= b; }
+
+  private:
+    volatile uint8_t bits;
+};
+
+// Timer/Counter 1
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TCCR1C;
+extern volatile uint8_t TIMSK1;
+extern HalFlags TIFR1;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+
+#define TOIE1 0
+#define TOV1 0
+
+// Timer/Counter 2
+extern volatile uint8_t TCCR2A;
+extern volatile uint8_t TCCR2B;
+extern volatile uint8_t TIMSK2;
+extern HalFlags TIFR2;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2A;
+extern volatile uint8_t OCR2B;
+
+#define OCIE2A 1
+#define OCF2A 1
+
+// ADC (as on the ATmega328P, so no MUX5)
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADCSRB;
+extern volatile uint16_t ADCW;
+
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+
+// Pin change interrupt 0 (port B, pins 8-13)
+extern volatile uint8_t PCICR;
+extern HalFlags PCIFR;
+extern volatile uint8_t PCMSK0;
+
+#define PCIE0 0
+#define PCIF0 0
@@ -0,0 +1,18 @@
+#pragma once
+
+// Host stand-in for avr/pgmspace.h: flash is ordinary memory.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define sprintf_P sprintf
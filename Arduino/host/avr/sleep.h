@@ -0,0 +1,13 @@
+#pragma once
+
+// Host stand-in for avr/sleep.h.  sleep_cpu() lets simulated time run until
+// an interrupt has been serviced.
+
+#define SLEEP_MODE_IDLE (0)
+
+void hal_sleep();
+
+static inline void set_sleep_mode(int mode) { (void)mode; }
+static inline void sleep_enable() {}
+static inline void sleep_disable() {}
+static inline void sleep_cpu() { hal_sleep(); }
@@ -0,0 +1,655 @@
+// Host HAL: Arduino core functions, AVR registers and a cycle based scheduler
+// that steps the emulated peripherals and runs the sketch's ISRs.
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+#include <string>
+#include <vector>
+
+#include "hal.h"
+
+// --------------------------------------------------------------------------------
+// Registers
+
+volatile uint8_t SREG;
+
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint8_t TCCR1C;
+volatile uint8_t TIMSK1;
+HalFlags TIFR1;
+volatile uint16_t TCNT1;
+volatile uint16_t OCR1A;
+volatile uint16_t OCR1B;
+
+volatile uint8_t TCCR2A;
+volatile uint8_t TCCR2B;
+volatile uint8_t TIMSK2;
+HalFlags TIFR2;
+volatile uint8_t TCNT2;
+volatile uint8_t OCR2A;
+volatile uint8_t OCR2B;
+
+volatile uint8_t ADMUX;
+volatile uint8_t ADCSRA;
+volatile uint8_t ADCSRB;
+volatile uint16_t ADCW;
+
+volatile uint8_t PCICR;
+HalFlags PCIFR;
+volatile uint8_t PCMSK0;
+
+// Interrupt vectors.  Weak, so a sketch need not define them all.
+extern "C" void PCINT0_vect(void) __attribute__((weak));
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER1_OVF_vect(void) __attribute__((weak));
+extern "C" void ADC_vect(void) __attribute__((weak));
+
+uint64_t hal_cycles = 0;
+
+// Pin levels, the levels digitalWrite() gave them (a timer output overrides that),
+// and the voltages on the analog pins as ADC readings
+static uint8_t pinLevel[NUM_DIGITAL_PINS];
+static uint8_t portLevel[NUM_DIGITAL_PINS];
+static int analogLevel[NUM_DIGITAL_PINS - A0];
+int hal_adcNoise = 0;
+
+// Edges recorded per pin, see hal_tracePin()
+static std::vector<HalEdge_s> *pinTrace[NUM_DIGITAL_PINS];
+
+// Port B is pins 8-13.  A change on one PCMSK0 selects flags pin change interrupt 0.
+#define PORTB_PIN0 (8)
+#define PORTB_PINS (6)
+
+static void pinSet(uint8_t pin, uint8_t level)
+{
+    if (level == pinLevel[pin]) return;
+
+    pinLevel[pin] = level;
+    if (pinTrace[pin]) {
+	HalEdge_s edge = { hal_cycles, level };
+	pinTrace[pin]->push_back(edge);
+    }
+    if ((pin >= PORTB_PIN0) && (pin < PORTB_PIN0 + PORTB_PINS) &&
+	(PCMSK0 & _BV(pin - PORTB_PIN0))) {
+	PCIFR.set(_BV(PCIF0));
+    }
+}
+
+// --------------------------------------------------------------------------------
+// Timer1, fast PWM with OCR1A as TOP (mode 15), which is all the sketch uses.
+// OC1B drives pin 10 according to COM1B: non-inverting (10) clears it at the
+// compare match and sets it at BOTTOM, inverting (11) the opposite.
+
+#define OC1B_PIN (10)
+#define COM1B_MASK (0x03 << 4)
+#define COM1B_10 (0x02 << 4)
+#define COM1B_11 (0x03 << 4)
+
+struct Timer1_s {
+    bool running;
+    uint64_t bottom;     // cycle the current period started
+    uint16_t top;        // TOP of the current period; OCR1A is loaded at TOP
+    uint16_t ocrb;       // OCR1B of the current period, also buffered
+    bool matched;        // compare B already happened this period
+    uint8_t oc1b;        // OC1B output level
+} _t1;
+
+static const unsigned t1Prescale[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+bool hal_trace = false;
+std::vector<HalEdge_s> hal_edges;
+
+
+static unsigned t1Div()
+{
+    return t1Prescale[TCCR1B & 0x07];
+}
+
+// Cycle of the compare B match this period, or ~0 if there is none to come.
+static uint64_t t1Compare()
+{
+    if (!_t1.running || _t1.matched || (_t1.ocrb > _t1.top)) return ~(uint64_t)0;
+    return _t1.bottom + (uint64_t)_t1.ocrb * t1Div();
+}
+
+// Cycle of the next overflow, or ~0 if the timer is stopped.
+static uint64_t t1Overflow()
+{
+    if (!_t1.running) return ~(uint64_t)0;
+    return _t1.bottom + ((uint64_t)_t1.top + 1) * t1Div();
+}
+
+static uint64_t t1NextEvent()
+{
+    uint64_t compare = t1Compare();
+    uint64_t overflow = t1Overflow();
+    return (compare < overflow) ? compare : overflow;
+}
+
+// Drive OC1B, if COM1B connects it to the pin, and record the edge.
+static void t1Output(uint8_t level)
+{
+    if ((TCCR1A & COM1B_MASK) < COM1B_10) return;
+    if (level == _t1.oc1b) return;
+
+    _t1.oc1b = level;
+    pinSet(OC1B_PIN, level);
+    if (hal_trace) {
+	HalEdge_s edge = { hal_cycles, level };
+	hal_edges.push_back(edge);
+    }
+}
+
+// A new period starts at BOTTOM, with the buffered compare registers.
+static void t1Bottom()
+{
+    _t1.top = OCR1A;
+    _t1.ocrb = OCR1B;
+    _t1.matched = false;
+    t1Output((TCCR1A & COM1B_MASK) == COM1B_10 ? HIGH : LOW);
+}
+
+static void t1Sync()
+{
+    if (!_t1.running && t1Div()) {
+	// clock was just selected
+	_t1.running = true;
+	_t1.bottom = hal_cycles;
+	t1Bottom();
+    }
+    if (_t1.running) {
+	TCNT1 = (hal_cycles - _t1.bottom) / t1Div();
+    }
+}
+
+// Compare B match, or TOP: overflow flag, and the next period starts.
+static void t1Event()
+{
+    if (hal_cycles == t1Compare()) {
+	_t1.matched = true;
+	t1Output((TCCR1A & COM1B_MASK) == COM1B_10 ? LOW : HIGH);
+	return;
+    }
+
+    _t1.bottom = t1Overflow();
+    TIFR1.set(_BV(TOV1));
+    t1Bottom();
+}
+
+// --------------------------------------------------------------------------------
+// Timer2, CTC mode with OCR2A as TOP (mode 2), which is all the sketch uses.
+// Compare A flags OCF2A.  Compare B drives OC2B (pin 3) according to COM2B:
+// toggle (01), clear (10) or set (11); with COM2B 00 the pin is the port's.
+// In CTC mode the compare registers aren't buffered.  TCNT2 may be written
+// while the timer is stopped.
+
+#define OC2B_PIN (3)
+#define COM2B_MASK (0x03 << 4)
+#define COM2B_01 (0x01 << 4)
+#define COM2B_10 (0x02 << 4)
+
+struct Timer2_s {
+    bool running;
+    uint64_t bottom;     // cycle the current period started
+    bool matchedA;       // compare A already happened this period
+    bool matchedB;       // and compare B
+    uint8_t com2b;       // COM2B as last seen
+    uint8_t oc2b;        // OC2B output level
+} _t2;
+
+static const unsigned t2Prescale[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+static unsigned t2Div()
+{
+    return t2Prescale[TCCR2B & 0x07];
+}
+
+// Cycle of a compare match this period, or ~0 if there is none to come.
+static uint64_t t2Compare(bool matched, uint8_t ocr)
+{
+    if (!_t2.running || matched || (ocr > OCR2A)) return ~(uint64_t)0;
+    return _t2.bottom + (uint64_t)ocr * t2Div();
+}
+
+// Cycle the counter clears after TOP, or ~0 if the timer is stopped.
+static uint64_t t2Clear()
+{
+    if (!_t2.running) return ~(uint64_t)0;
+    return _t2.bottom + ((uint64_t)OCR2A + 1) * t2Div();
+}
+
+static uint64_t t2NextEvent()
+{
+    uint64_t next = t2Clear();
+    uint64_t a = t2Compare(_t2.matchedA, OCR2A);
+    uint64_t b = t2Compare(_t2.matchedB, OCR2B);
+    if (a < next) next = a;
+    if (b < next) next = b;
+    return next;
+}
+
+static void t2Sync()
+{
+    uint8_t com = TCCR2A & COM2B_MASK;
+
+    if (com != _t2.com2b) {
+	// OC2B takes the pin over, or hands it back
+	_t2.com2b = com;
+	pinSet(OC2B_PIN, com ? _t2.oc2b : portLevel[OC2B_PIN]);
+    }
+
+    if (!_t2.running && t2Div()) {
+	// clock was just selected
+	_t2.running = true;
+	_t2.bottom = hal_cycles - (uint64_t)TCNT2 * t2Div();
+	_t2.matchedA = (TCNT2 > OCR2A);
+	_t2.matchedB = (TCNT2 > OCR2B);
+    }
+    else if (_t2.running && !t2Div()) {
+	_t2.running = false;
+    }
+    if (_t2.running) {
+	TCNT2 = (hal_cycles - _t2.bottom) / t2Div();
+    }
+}
+
+// The counter clears, then compare B drives OC2B and compare A sets its flag.
+static void t2Event()
+{
+    if (hal_cycles == t2Clear()) {
+	_t2.bottom = hal_cycles;
+	_t2.matchedA = false;
+	_t2.matchedB = false;
+    }
+    if (hal_cycles == t2Compare(_t2.matchedB, OCR2B)) {
+	_t2.matchedB = true;
+	switch (_t2.com2b) {
+	    case COM2B_01: _t2.oc2b = !_t2.oc2b; break;
+	    case COM2B_10: _t2.oc2b = LOW; break;
+	    case 0: break;
+	    default: _t2.oc2b = HIGH; break;
+	}
+	if (_t2.com2b) pinSet(OC2B_PIN, _t2.oc2b);
+    }
+    if (hal_cycles == t2Compare(_t2.matchedA, OCR2A)) {
+	_t2.matchedA = true;
+	TIFR2.set(_BV(OCF2A));
+    }
+}
+
+// --------------------------------------------------------------------------------
+// ADC, single conversions started by ADSC.  A conversion takes 13 ADC clocks,
+// 25 for the first after ADEN is set, and reads the analog pin ADMUX selects
+// (plus noise, if hal_adcNoise is set).
+
+struct Adc_s {
+    bool enabled;
+    bool busy;
+    bool first;          // next conversion is the first since ADEN was set
+    uint8_t chan;        // channel being converted
+    uint64_t done;       // cycle the conversion finishes
+} _adc;
+
+static uint64_t adcNextEvent()
+{
+    if (!_adc.busy) return ~(uint64_t)0;
+    return _adc.done;
+}
+
+static void adcSync()
+{
+    if (!(ADCSRA & _BV(ADEN))) {
+	_adc.enabled = false;
+	_adc.busy = false;
+	ADCSRA &= ~_BV(ADSC);
+	return;
+    }
+    if (!_adc.enabled) {
+	_adc.enabled = true;
+	_adc.first = true;
+    }
+
+    if (!_adc.busy && (ADCSRA & _BV(ADSC))) {
+	unsigned div = 1 << (ADCSRA & 0x07);
+	if (div == 1) div = 2;
+
+	// MUX and reference are latched as the conversion starts.
+	_adc.busy = true;
+	_adc.chan = ADMUX & 0x07;
+	_adc.done = hal_cycles + (uint64_t)(_adc.first ? 25 : 13) * div;
+	_adc.first = false;
+    }
+}
+
+static void adcEvent()
+{
+    int value = 0;
+
+    if (_adc.chan < NUM_DIGITAL_PINS - A0) {
+	value = analogLevel[_adc.chan];
+    }
+    if (hal_adcNoise) {
+	value += rand() % (2 * hal_adcNoise + 1) - hal_adcNoise;
+    }
+    if (value < 0) value = 0;
+    if (value > 1023) value = 1023;
+
+    ADCW = value;
+    _adc.busy = false;
+    ADCSRA = (ADCSRA & ~_BV(ADSC)) | _BV(ADIF);
+}
+
+// --------------------------------------------------------------------------------
+// Input pin changes scheduled by the simulator, in time order
+
+struct PinEvent_s {
+    uint64_t cycle;
+    uint8_t pin;
+    uint8_t level;
+};
+static std::vector<PinEvent_s> pinEvents;
+
+static uint64_t pinNextEvent()
+{
+    if (pinEvents.empty()) return ~(uint64_t)0;
+    return pinEvents.front().cycle;
+}
+
+static void pinEvent()
+{
+    while (!pinEvents.empty() && (pinEvents.front().cycle <= hal_cycles)) {
+	pinSet(pinEvents.front().pin, pinEvents.front().level);
+	pinEvents.erase(pinEvents.begin());
+    }
+}
+
+// --------------------------------------------------------------------------------
+// Scheduler
+
+// Bring the emulated peripherals up to hal_cycles, and pick up register writes.
+static void hwSync()
+{
+    t1Sync();
+    t2Sync();
+    adcSync();
+}
+
+// Run one pending, enabled interrupt, if interrupts are on.
+// Lower vector numbers first, as on the AVR.
+static bool dispatch()
+{
+    if (!(SREG & 0x80)) return false;
+
+    if ((PCIFR & _BV(PCIF0)) && (PCICR & _BV(PCIE0)) && PCINT0_vect) {
+	PCIFR = _BV(PCIF0);
+	cli();
+	PCINT0_vect();
+	sei();
+	return true;
+    }
+
+    if ((TIFR2 & _BV(OCF2A)) && (TIMSK2 & _BV(OCIE2A)) && TIMER2_COMPA_vect) {
+	TIFR2 = _BV(OCF2A);
+	cli();
+	TIMER2_COMPA_vect();
+	sei();
+	return true;
+    }
+
+    if ((TIFR1 & _BV(TOV1)) && (TIMSK1 & _BV(TOIE1)) && TIMER1_OVF_vect) {
+	TIFR1 = _BV(TOV1);
+	cli();
+	TIMER1_OVF_vect();
+	sei();
+	return true;
+    }
+
+    if ((ADCSRA & _BV(ADIF)) && (ADCSRA & _BV(ADIE)) && ADC_vect) {
+	ADCSRA &= ~_BV(ADIF);
+	cli();
+	ADC_vect();
+	sei();
+	return true;
+    }
+
+    return false;
+}
+
+// Step to the next hardware event, but not past limit.  Returns true if an
+// interrupt was serviced.
+static bool step(uint64_t limit)
+{
+    uint64_t t1 = t1NextEvent();
+    uint64_t t2 = t2NextEvent();
+    uint64_t adc = adcNextEvent();
+    uint64_t pin = pinNextEvent();
+    uint64_t next = (adc < t1) ? adc : t1;
+    if (t2 < next) next = t2;
+    if (pin < next) next = pin;
+
+    if (next > limit) {
+	hal_cycles = limit;
+	hwSync();
+	return false;
+    }
+
+    hal_cycles = next;
+    if (next == t1) t1Event();
+    if (next == t2) t2Event();
+    if (next == adc) adcEvent();
+    if (next == pin) pinEvent();
+    hwSync();
+
+    bool serviced = false;
+    while (dispatch()) {
+	serviced = true;
+	hwSync();
+    }
+    return serviced;
+}
+
+void hal_advance(uint64_t cycles)
+{
+    uint64_t end = hal_cycles + cycles;
+
+    hwSync();
+    while (dispatch()) {
+	hwSync();
+    }
+    while (hal_cycles < end) {
+	step(end);
+    }
+}
+
+void hal_spendUs(unsigned long us)
+{
+    hal_advance((uint64_t)us * HAL_CYCLES_PER_US);
+}
+
+void hal_sleep()
+{
+    hwSync();
+    if (dispatch()) {
+	// an interrupt was already pending: it wakes us at once
+	do {
+	    hwSync();
+	} while (dispatch());
+	return;
+    }
+
+    if (!(SREG & 0x80) || (!_t1.running && !_t2.running && !_adc.busy && pinEvents.empty())) {
+	fprintf(stderr, "hal: sleep_cpu() with nothing to wake it\n");
+	exit(1);
+    }
+
+    while (!step(~(uint64_t)0)) {}
+}
+
+// --------------------------------------------------------------------------------
+// Arduino core
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= NUM_DIGITAL_PINS) return;
+    if (mode == INPUT_PULLUP) pinSet(pin, HIGH);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin >= NUM_DIGITAL_PINS) return;
+    portLevel[pin] = val ? HIGH : LOW;
+    if ((pin == OC2B_PIN) && _t2.com2b) return;
+    pinSet(pin, portLevel[pin]);
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS) return LOW;
+    return pinLevel[pin];
+}
+
+int analogRead(uint8_t pin)
+{
+    if (pin < A0) pin += A0;
+    if (pin >= NUM_DIGITAL_PINS) return 0;
+
+    // A conversion takes 13 ADC clocks at 125kHz.
+    hal_spendUs(104);
+    return analogLevel[pin - A0];
+}
+
+unsigned long micros()
+{
+    return hal_cycles / HAL_CYCLES_PER_US;
+}
+
+unsigned long millis()
+{
+    return hal_cycles / (HAL_CYCLES_PER_US * 1000);
+}
+
+void delay(unsigned long ms)
+{
+    hal_spendUs(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hal_spendUs(us);
+}
+
+void hal_setAnalog(uint8_t pin, int value)
+{
+    if (pin < A0) pin += A0;
+    if (pin >= NUM_DIGITAL_PINS) return;
+    analogLevel[pin - A0] = value;
+}
+
+void hal_setPin(uint8_t pin, int level)
+{
+    if (pin >= NUM_DIGITAL_PINS) return;
+    pinSet(pin, level ? HIGH : LOW);
+}
+
+void hal_setPinAt(uint64_t cycle, uint8_t pin, int level)
+{
+    if (pin >= NUM_DIGITAL_PINS) return;
+    if (cycle <= hal_cycles) {
+	hal_setPin(pin, level);
+	return;
+    }
+
+    PinEvent_s event = { cycle, pin, (uint8_t)(level ? HIGH : LOW) };
+    std::vector<PinEvent_s>::iterator at = pinEvents.begin();
+    while ((at != pinEvents.end()) && (at->cycle <= cycle)) ++at;
+    pinEvents.insert(at, event);
+}
+
+void hal_tracePin(uint8_t pin, std::vector<HalEdge_s> *edges)
+{
+    if (pin >= NUM_DIGITAL_PINS) return;
+    pinTrace[pin] = edges;
+}
+
+int hal_getPin(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS) return LOW;
+    return pinLevel[pin];
+}
+
+// --------------------------------------------------------------------------------
+// Serial
+
+HardwareSerial Serial;
+bool hal_serialEcho = true;
+static std::string serialIn;
+
+void hal_serialInput(const char *s)
+{
+    serialIn += s;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    (void)baud;
+}
+
+int HardwareSerial::available()
+{
+    return serialIn.size();
+}
+
+int HardwareSerial::read()
+{
+    if (serialIn.empty()) return -1;
+
+    int c = (unsigned char)serialIn[0];
+    serialIn.erase(0, 1);
+    return c;
+}
+
+void HardwareSerial::print(const char *s)
+{
+    if (hal_serialEcho) fputs(s, stdout);
+}
+
+void HardwareSerial::print(const __FlashStringHelper *s)
+{
+    print(reinterpret_cast<const char *>(s));
+}
+
+void HardwareSerial::print(char c)
+{
+    if (hal_serialEcho) putchar(c);
+}
+
+void HardwareSerial::print(long n, int base)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), (base == HEX) ? "%lx" : "%ld", n);
+    print(buf);
+}
+
+void HardwareSerial::print(unsigned long n, int base)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), (base == HEX) ? "%lx" : "%lu", n);
+    print(buf);
+}
+
+void HardwareSerial::print(int n, int base)
+{
+    print((long)n, base);
+}
+
+void HardwareSerial::print(unsigned n, int base)
+{
+    print((unsigned long)n, base);
+}
+
+void HardwareSerial::println()
+{
+    print("\n");
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// Host HAL control interface, for the simulator.  The sketch doesn't see this.
+//
+// Simulated time is counted in CPU cycles at F_CPU.  The sketch's own code runs
+// in zero simulated time; time passes only when the sketch sleeps or calls
+// something the HAL charges for (analogRead(), display refresh).  Hardware
+// (Timer1, Timer2, ...) is stepped from event to event, and interrupts run in between.
+
+#include <stdint.h>
+#include <vector>
+
+#define HAL_CYCLES_PER_US (F_CPU / 1000000UL)
+
+// Current simulated time, CPU cycles since reset.
+extern uint64_t hal_cycles;
+
+// Let time pass, servicing interrupts as they come due.
+void hal_advance(uint64_t cycles);
+void hal_spendUs(unsigned long us);
+
+// sleep_cpu(): run until at least one interrupt has been serviced.
+void hal_sleep();
+
+// Inputs
+void hal_setAnalog(uint8_t pin, int value);  // pin is A0...
+extern int hal_adcNoise;                     // each ADC reading is off by up to this much
+void hal_setPin(uint8_t pin, int level);
+void hal_setPinAt(uint64_t cycle, uint8_t pin, int level);  // later, as time passes
+
+// Outputs
+int hal_getPin(uint8_t pin);
+
+// Edges of Timer1's OC1B output (pin 10, the PPM signal), recorded while
+// hal_trace is set.  See trace.h to analyze them.
+struct HalEdge_s {
+    uint64_t cycle;
+    uint8_t level;
+};
+extern bool hal_trace;
+extern std::vector<HalEdge_s> hal_edges;
+
+// Record every change of a pin's level in edges, or stop if edges is NULL.
+void hal_tracePin(uint8_t pin, std::vector<HalEdge_s> *edges);
+
+// Serial port: queue input for Serial.read(); echo output to stdout or not.
+void hal_serialInput(const char *s);
+extern bool hal_serialEcho;
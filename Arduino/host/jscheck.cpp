@@ -0,0 +1,157 @@
+// jscheck: compares the joystick's integer sector classifiers with the float
+// ones they replaced, for every x, y the ADC can give, in both stick directions
+// (JS_DIR_X, JS_DIR_Y).  Prints the mismatches, and exits 1 if there are any.
+//
+// avr-gcc's double is IEEE single precision, so the float versions below do all
+// their arithmetic and compares in float, as they did on the AVR.
+
+#include <Arduino.h>
+
+#include "Joystick.h"
+
+#define TAN_37_5 ((float)0.76732699)
+#define TAN_33_75 ((float)0.66817864)
+#define TAN_22_5 ((float)0.41421356)
+#define TAN_11_25 ((float)0.19891237)
+#define TAN_7_5 ((float)0.13165250)
+
+// fold x, y into 0, 1 positions
+static void fold(int *x, int *y, bool *fold_x, bool *fold_y, bool *fold_xy)
+{
+    int tmp;
+
+    *fold_x = *fold_y = *fold_xy = false;
+    if (*y < 0) {
+	*fold_x = true;
+	*y = -*y;
+    }
+    if (*x < 0) {
+	*fold_y = true;
+	*x = -*x;
+    }
+    if (*y > *x) {
+	*fold_xy = true;
+	tmp = *x;
+	*x = *y;
+	*y = tmp;
+    }
+}
+
+static int floatIndex24(int x, int y)
+{
+    bool fold_x, fold_y, fold_xy;
+    int index = 0;
+
+    fold(&x, &y, &fold_x, &fold_y, &fold_xy);
+
+    float t = (float)y/(float)x;
+    if (t > TAN_22_5) {
+	if (t > TAN_37_5) {
+	    index = 3;
+	}
+	else {
+	    index = 2;
+	}
+    }
+    else {
+	if (t > TAN_7_5) {
+	    index = 1;
+	}
+	else {
+	    index = 0;
+	}
+    }
+
+    // unfold as necessary
+    if (fold_xy) index = 6 - index;
+    if (fold_y) index = 12 - index;
+    if (fold_x) index = 24 - index;
+    if (index == 24) index = 0;
+
+    return index;
+}
+
+static int floatIndex16(int x, int y)
+{
+    bool fold_x, fold_y, fold_xy;
+    int index = 0;
+
+    fold(&x, &y, &fold_x, &fold_y, &fold_xy);
+
+    float t = (float)y/(float)x;
+    if (t > TAN_22_5) {
+	index = 1;
+    }
+
+    // unfold as necessary
+    if (fold_xy) index = 3 - index;
+    if (fold_y) index = 7 - index;
+    if (fold_x) index = 15 - index;
+
+    return index;
+}
+
+static int floatIndex16_offs(int x, int y)
+{
+    bool fold_x, fold_y, fold_xy;
+    int index = 0;
+
+    fold(&x, &y, &fold_x, &fold_y, &fold_xy);
+
+    float t = (float)y/(float)x;
+    if (t < TAN_22_5) {
+	if (t < TAN_11_25) {
+	    index = 0;
+	}
+	else {
+	    index = 1;
+	}
+    }
+    else {
+	if (t < TAN_33_75) {
+	    index = 1;
+	}
+	else {
+	    index = 2;
+	}
+    }
+
+    // unfold as necessary
+    if (fold_xy) index = 4 - index;
+    if (fold_y) index = 8 - index;
+    if (fold_x) index = 16 - index;
+    if (index == 16) index = 0;
+
+    return index;
+}
+
+static unsigned long mismatches;
+
+static void compare(const char *name, int x, int y, int got, int want)
+{
+    if (got == want) return;
+    if (mismatches++ < 20) {
+	printf("%s(%d, %d): %d, float gave %d\n", name, x, y, got, want);
+    }
+}
+
+int main()
+{
+    Joystick js;
+    unsigned long points = 0;
+
+    // x = dir * (512 - sample), sample 0 to 1023, dir 1 or -1: -512 to 512
+    for (int x = -512; x <= 512; x++) {
+	for (int y = -512; y <= 512; y++) {
+	    js.x = x;
+	    js.y = y;
+	    compare("getIndex24", x, y, js.getIndex24(), floatIndex24(x, y));
+	    compare("getIndex16", x, y, js.getIndex16(), floatIndex16(x, y));
+	    compare("getIndex16_offs", x, y, js.getIndex16_offs(), floatIndex16_offs(x, y));
+	    points++;
+	}
+    }
+
+    printf("jscheck: %lu stick positions, %lu mismatches\n", points, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+// seqcheck: runs a pattern that mixes portrait and landscape shots (P_HOVER),
+// which no shoot mode uses yet.  Checks the orientation ShotSequence gives each
+// shot, for both user orientations.  Then queues the shots and runs the sketch
+// until they are all taken, checking that at each shutter press the HoVer
+// servo is still, in the shot's orientation, and has been for long enough.
+// Prints what is wrong, and exits 1 if anything is.
+
+#include <Arduino.h>
+
+#include "hal.h"
+#include "Model.h"
+#include "Sequence.h"
+#include "Tuning.h"
+
+// From the sketch
+void setup();
+void loop();
+extern Model model;
+
+static const uint8_t patMixed[] PROGMEM = {
+    P_SHOTS, 2, OFF(0, 0), OFF(2, 0),
+    P_HOVER, HV_OTHER,
+    P_SHOTS, 2, OFF(2, -2), OFF(0, -2),
+    P_HOVER, HV_VERT,
+    P_SHOTS, 1, OFF(-2, -2),
+    P_HOVER, HV_HOR,
+    P_SHOTS, 1, OFF(-2, -2),      // the same aim point: a HoVer flip alone
+    P_HOVER, HV_USER,
+    P_SHOTS, 1, OFF(0, -4),
+    P_END,
+};
+
+#define MIXED_SHOTS (7)
+
+// Orientation of each shot, for a user's horizontal and vertical
+static const bool mixedVert[2][MIXED_SHOTS] = {
+    { false, false, true, true, true, false, false },
+    { true, true, false, false, true, false, true },
+};
+
+static unsigned long failures;
+
+static void fail(const char *what, unsigned shot, long got, long want)
+{
+    printf("seqcheck: shot %u: %s %ld, want %ld\n", shot, what, got, want);
+    failures++;
+}
+
+// The orientation of each shot, as ShotSequence gives it.
+static void checkSequence(bool userVert)
+{
+    ShotSequence seq;
+    PanTilt_t user = { 0, 0 };
+    PanTilt_t aimPoint;
+    bool vert;
+    unsigned n = 0;
+
+    seq.start(patMixed, 1, &user, userVert);
+    if (seq.remaining() != MIXED_SHOTS) {
+	fail("shots in the sequence", 0, seq.remaining(), MIXED_SHOTS);
+	return;
+    }
+    while (seq.next(&aimPoint, &vert)) {
+	if (vert != mixedVert[userVert][n]) {
+	    fail(userVert ? "vertical (user vertical)" : "vertical (user horizontal)",
+		 n, vert, mixedVert[userVert][n]);
+	}
+	n++;
+    }
+}
+
+// The sketch taking the shots.
+static void checkShots()
+{
+    ShotSequence seq;
+    PanTilt_t user;
+    PanTilt_t aimPoint;
+    bool vert;
+    bool userVert = model.getHoVer();
+
+    model.getUserPos(&user);
+    seq.start(patMixed, 1, &user, userVert);
+    while (seq.next(&aimPoint, &vert)) {
+	model.queueShot(&aimPoint, 1, vert);
+    }
+
+    uint64_t end = hal_cycles + (uint64_t)60 * F_CPU;
+    unsigned shots = 0;
+    bool shutter = false;
+    int hoVerPwm = model.getHoVerPwm();
+    unsigned still = 0;          // frames the HoVer servo has not moved for
+    Shot_t last = SHOT_SET_VERT(SHOT(0, 0), userVert);
+
+    while ((model.getShotsQueued() || shutter) && (hal_cycles < end)) {
+	loop();
+
+	if (model.getHoVerPwm() != hoVerPwm) {
+	    hoVerPwm = model.getHoVerPwm();
+	    still = 0;
+	}
+	else {
+	    still++;
+	}
+
+	if (model.getShutter() && !shutter) {
+	    Shot_t shot = model.getShot(0);
+	    long pos;
+	    long vel;
+
+	    model.getHoVerServo(&pos, &vel);
+	    if (shots < MIXED_SHOTS) {
+		if ((bool)SHOT_VERT(shot) != mixedVert[userVert][shots]) {
+		    fail("vertical", shots, SHOT_VERT(shot), mixedVert[userVert][shots]);
+		}
+	    }
+	    if (hoVerPwm != Model::hoVerToPwm(SHOT_VERT(shot))) {
+		fail("HoVer PWM", shots, hoVerPwm, Model::hoVerToPwm(SHOT_VERT(shot)));
+	    }
+	    if (vel) {
+		fail("HoVer velocity", shots, vel, 0);
+	    }
+	    if (SHOT_VERT(shot) != SHOT_VERT(last)) {
+		// A flip alone is still a full speed move for the HoVer servo.
+		bool flipOnly = (SHOT_PAN(shot) == SHOT_PAN(last)) &&
+		    (SHOT_TILT(shot) == SHOT_TILT(last));
+		unsigned want = flipOnly ? TIME_STABILIZING_MAX : TIME_STABILIZING_MIN;
+
+		if (still < want) {
+		    fail("frames still after a HoVer flip", shots, still, want);
+		}
+	    }
+	    last = shot;
+	    shots++;
+	}
+	shutter = model.getShutter();
+    }
+
+    if (shots != MIXED_SHOTS) {
+	fail("shots taken", shots, shots, MIXED_SHOTS);
+    }
+}
+
+int main()
+{
+    hal_serialEcho = false;
+
+    // Joystick centered, button up
+    hal_setAnalog(A0, 512);
+    hal_setAnalog(A1, 512);
+
+    checkSequence(false);
+    checkSequence(true);
+
+    sei();
+    setup();
+    checkShots();
+
+    printf("seqcheck: %lu failures\n", failures);
+    return failures ? 1 : 0;
+}
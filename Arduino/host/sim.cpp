@@ -0,0 +1,246 @@
+// kaptx_sim: runs the kaptx sketch on the host against the HAL, much faster
+// than real time, and reports throughput.
+//
+// usage: kaptx_sim [options]; kaptx_sim -h lists them.
+
+#include <Arduino.h>
+#include <Adafruit_SharpMem.h>
+
+#include <unistd.h>
+
+#include "hal.h"
+#include "trace.h"
+#include "Model.h"
+#include "Trigger.h"
+#include "Tuning.h"
+
+// From the sketch
+void setup();
+void loop();
+extern Model model;
+extern Adafruit_SharpMem display;
+
+#define USAGE "usage: kaptx_sim [-h] [-t seconds] [-m mode] [-a] [-l us] [-n counts] [-c ms] [-f ms] [-r ms] [-s] [-v] [-d file] [-p] [-w file] [-g]\n"
+
+static const char options[] =
+    "  -h           list the options\n"
+    "  -t seconds   simulated time to run (default 60)\n"
+    "  -m mode      shoot mode 0-5: single, cluster, vpan, hpan, quad, 360 (default 0)\n"
+    "  -a           autokap: start a new sequence whenever the last one is done\n"
+    "  -l us        time one LCD refresh takes (default 12000)\n"
+    "  -n counts    joystick ADC noise: readings are off by up to this much (default 0)\n"
+    "  -c ms        camera feedback: signal on CAMERA_PIN this long after each shutter press\n"
+    "  -f ms        camera autofocus time: with -c, the signal comes this much later too,\n"
+    "               unless the shutter was half pressed at least this long before\n"
+    "  -r ms        shutter servo travel: with -c, the camera sees a servo's press this much\n"
+    "               later (not in builds with an electronic trigger, which reach it at once)\n"
+    "  -s           print the sketch's slack statistics at the end\n"
+    "  -v           show the sketch's serial output\n"
+    "  -d file      write the final LCD image to file (PBM)\n"
+    "  -p           report the PPM output timing: frames, channels, sync gap, jitter\n"
+    "  -w file      write the PPM output to file as a VCD waveform\n"
+    "  -g           report the shutter trigger's output: IR codes or wired remote presses\n"
+;
+
+static void usage()
+{
+    fputs(USAGE, stderr);
+    exit(2);
+}
+
+static void help()
+{
+    fputs(USAGE, stdout);
+    fputs(options, stdout);
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 60;
+    int mode = MODE_SINGLE;
+    bool autokap = false;
+    bool slack = false;
+    const char *lcdFile = NULL;
+    bool ppmReport = false;
+    const char *vcdFile = NULL;
+    long cameraMs = -1;
+    long focusMs = 0;
+    long servoMs = 0;
+    bool trigReport = false;
+    std::vector<HalEdge_s> trigEdges;    // IR LED, or the wired shutter line
+    std::vector<HalEdge_s> focusEdges;   // wired focus line
+    int opt;
+
+    hal_serialEcho = false;
+    while ((opt = getopt(argc, argv, "ht:m:al:n:c:f:r:svd:pw:g")) != -1) {
+	switch (opt) {
+	    case 'h':
+		help();
+		break;
+	    case 't':
+		seconds = atof(optarg);
+		break;
+	    case 'm':
+		mode = atoi(optarg);
+		if ((mode < 0) || (mode >= NUM_MODES)) usage();
+		break;
+	    case 'a':
+		autokap = true;
+		break;
+	    case 'l':
+		hal_lcdRefreshUs = atol(optarg);
+		break;
+	    case 'n':
+		hal_adcNoise = atoi(optarg);
+		break;
+	    case 'c':
+		cameraMs = atol(optarg);
+		break;
+	    case 'f':
+		focusMs = atol(optarg);
+		break;
+	    case 'r':
+		servoMs = atol(optarg);
+		break;
+	    case 's':
+		slack = true;
+		break;
+	    case 'v':
+		hal_serialEcho = true;
+		break;
+	    case 'd':
+		lcdFile = optarg;
+		break;
+	    case 'p':
+		ppmReport = true;
+		break;
+	    case 'w':
+		vcdFile = optarg;
+		break;
+	    case 'g':
+		trigReport = true;
+		break;
+	    default:
+		usage();
+	}
+    }
+
+    // Joystick centered, button up
+    hal_setAnalog(A0, 512);
+    hal_setAnalog(A1, 512);
+
+    hal_trace = ppmReport || vcdFile;
+
+    if (trigReport) {
+#if defined(WIRED_SHUTTER_PIN)
+	hal_tracePin(WIRED_SHUTTER_PIN, &trigEdges);
+	hal_tracePin(WIRED_FOCUS_PIN, &focusEdges);
+#elif defined(IR_CANON)
+	hal_tracePin(IR_PIN, &trigEdges);
+#endif
+    }
+
+#ifndef CAMERA_PIN
+    if ((cameraMs >= 0) || focusMs || servoMs) {
+	fprintf(stderr, "kaptx_sim: -c, -f and -r need CAMERA_PIN defined in Tuning.h\n");
+	return 2;
+    }
+#endif
+#if defined(WIRED_SHUTTER_PIN) || defined(IR_CANON)
+    if (servoMs) {
+	fprintf(stderr, "kaptx_sim: -r is for the shutter servo, and this build has an electronic trigger\n");
+	return 2;
+    }
+#endif
+
+    sei();
+    setup();
+
+    model.setDispMode((Mode_t)mode);
+    model.setModeToDispMode();
+    model.setAuto(autokap);
+
+    uint64_t end = (uint64_t)(seconds * F_CPU);
+    unsigned long loops = 0;
+    unsigned long shots = 0;
+    bool shutter = false;
+#ifdef CAMERA_PIN
+    bool half = false;
+    uint64_t halfStart = 0;
+#endif
+
+    while (hal_cycles < end) {
+	loop();
+	loops++;
+
+#ifdef CAMERA_PIN
+	if (model.getShutterHalf() && !half) {
+	    halfStart = hal_cycles;
+	}
+	half = model.getShutterHalf();
+#endif
+
+	if (model.getShutter() && !shutter) {
+	    shots++;
+#ifdef CAMERA_PIN
+	    if (cameraMs >= 0) {
+		// the camera's signal goes inactive as it starts on the frame (a card
+		// busy LED lights), and active once it has focused, shot and written it
+		uint64_t focus = (uint64_t)focusMs * 1000 * HAL_CYCLES_PER_US;
+		uint64_t at = hal_cycles + (uint64_t)(cameraMs + servoMs) * 1000 * HAL_CYCLES_PER_US;
+		if (!half || (hal_cycles - halfStart < focus)) at += focus;
+		hal_setPinAt(hal_cycles, CAMERA_PIN, !CAMERA_ACTIVE);
+		hal_setPinAt(at, CAMERA_PIN, CAMERA_ACTIVE);
+	    }
+#endif
+	}
+	shutter = model.getShutter();
+    }
+
+    printf("simulated %.1f s, %lu loops, %lu LCD refreshes\n",
+	   hal_cycles / (double)F_CPU, loops, display.refreshes);
+    printf("shots %lu, %.1f per minute\n", shots, shots * 60.0 * F_CPU / hal_cycles);
+
+    if (slack) {
+	hal_serialEcho = true;
+	hal_serialInput("s");
+	loop();
+    }
+
+    if (ppmReport) {
+	traceReport(stdout, hal_edges);
+    }
+
+    if (trigReport) {
+#if defined(WIRED_SHUTTER_PIN)
+	traceWiredReport(stdout, focusEdges, trigEdges);
+#elif defined(IR_CANON)
+	traceIrReport(stdout, trigEdges);
+#else
+	printf("trigger: the shutter servo, on PPM channel 3 (see -p)\n");
+#endif
+    }
+
+    if (vcdFile) {
+	FILE *f = fopen(vcdFile, "w");
+	if (!f) {
+	    perror(vcdFile);
+	    return 1;
+	}
+	traceVcd(f, hal_edges);
+	fclose(f);
+    }
+
+    if (lcdFile) {
+	FILE *f = fopen(lcdFile, "w");
+	if (!f) {
+	    perror(lcdFile);
+	    return 1;
+	}
+	display.dumpPbm(f);
+	fclose(f);
+    }
+
+    return 0;
+}
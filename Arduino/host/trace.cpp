@@ -0,0 +1,261 @@
+// PPM trace export and analysis.
+//
+// The PPM output idles high and each phase starts with a low pulse, so the
+// falling edges mark the phases: a channel's width is the time from its
+// falling edge to the next.  A frame is the channels between two sync gaps,
+// and its start is the falling edge that ends the first gap.
+
+#include <Arduino.h>
+
+#include "trace.h"
+#include "Tuning.h"
+
+#define TRACE_MAX_CHANNELS (16)
+
+// VCD time unit: 100pS, so that one 16MHz cycle (62.5nS) is a whole number.
+#define VCD_PER_CYCLE (10000000000ULL / F_CPU)
+
+struct TraceStat_s {
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    unsigned long count;
+};
+
+static void statAdd(TraceStat_s *stat, uint64_t cycles)
+{
+    if (!stat->count || (cycles < stat->min)) stat->min = cycles;
+    if (!stat->count || (cycles > stat->max)) stat->max = cycles;
+    stat->sum += cycles;
+    stat->count++;
+}
+
+static double us(double cycles)
+{
+    return cycles / (F_CPU / 1000000.0);
+}
+
+static void statPrint(FILE *f, const char *name, const TraceStat_s *stat)
+{
+    if (!stat->count) {
+	fprintf(f, "%s: none\n", name);
+	return;
+    }
+    fprintf(f, "%s uS: min %.1f avg %.1f max %.1f\n", name,
+	    us(stat->min), us((double)stat->sum / stat->count), us(stat->max));
+}
+
+void traceVcd(FILE *f, const std::vector<HalEdge_s> &edges)
+{
+    fprintf(f, "$timescale 100ps $end\n");
+    fprintf(f, "$scope module kaptx $end\n");
+    fprintf(f, "$var wire 1 ! ppm $end\n");
+    fprintf(f, "$upscope $end\n");
+    fprintf(f, "$enddefinitions $end\n");
+    fprintf(f, "#0\n$dumpvars\n0!\n$end\n");
+
+    for (size_t n = 0; n < edges.size(); n++) {
+	fprintf(f, "#%llu\n%u!\n",
+		(unsigned long long)(edges[n].cycle * VCD_PER_CYCLE), edges[n].level);
+    }
+}
+
+void traceReport(FILE *f, const std::vector<HalEdge_s> &edges)
+{
+    const uint64_t syncCycles = (uint64_t)TRACE_SYNC_US * (F_CPU / 1000000);
+
+    TraceStat_s frame = {};
+    TraceStat_s sync = {};
+    TraceStat_s pulse = {};
+    TraceStat_s chan[TRACE_MAX_CHANNELS] = {};
+    unsigned chanMin = ~0u;
+    unsigned chanMax = 0;
+    std::vector<uint64_t> starts;   // frame start edges
+
+    bool inFrame = false;   // a sync gap has been seen, so phases are channels
+    unsigned n = 0;         // channel number within the frame
+    uint64_t lastFall = 0;
+    bool haveFall = false;
+
+    for (size_t e = 0; e < edges.size(); e++) {
+	uint64_t t = edges[e].cycle;
+
+	if (edges[e].level) {
+	    if (haveFall) statAdd(&pulse, t - lastFall);
+	    continue;
+	}
+
+	if (haveFall) {
+	    uint64_t phase = t - lastFall;
+
+	    if (phase > syncCycles) {
+		if (inFrame && (n == 0)) {
+		    // back to back gaps, as while the output starts up:
+		    // one long gap to a receiver.
+		    starts.pop_back();
+		}
+		else if (inFrame) {
+		    statAdd(&sync, phase);
+		    statAdd(&frame, t - starts.back());
+		    if (n < chanMin) chanMin = n;
+		    if (n > chanMax) chanMax = n;
+		}
+		// this edge ends the gap: a frame starts
+		inFrame = true;
+		n = 0;
+		starts.push_back(t);
+	    }
+	    else if (inFrame) {
+		if (n < TRACE_MAX_CHANNELS) statAdd(&chan[n], phase);
+		n++;
+	    }
+	}
+	lastFall = t;
+	haveFall = true;
+    }
+
+    if (starts.size() < 2) {
+	fprintf(f, "ppm: no complete frames in %lu edges\n", (unsigned long)edges.size());
+	return;
+    }
+
+    // Frame start jitter: the worst distance of a frame start from an even
+    // grid through the first and last.
+    size_t frames = starts.size() - 1;
+    double period = (double)(starts.back() - starts.front()) / frames;
+    double jitter = 0;
+    for (size_t k = 0; k <= frames; k++) {
+	double d = (double)(starts[k] - starts.front()) - k * period;
+	if (d < 0) d = -d;
+	if (d > jitter) jitter = d;
+    }
+
+    fprintf(f, "ppm: %lu frames, %u-%u channels (PPM_CHANNELS %u)\n",
+	    (unsigned long)frames, chanMin, chanMax, PPM_CHANNELS);
+    statPrint(f, "frame", &frame);
+    fprintf(f, "frame period uS %.1f (PPM_FRAME_US %u), start jitter uS %.1f\n",
+	    us(period), PPM_FRAME_US, us(jitter));
+    statPrint(f, "sync gap", &sync);
+    statPrint(f, "pulse", &pulse);
+    for (unsigned c = 0; (c < chanMax) && (c < TRACE_MAX_CHANNELS); c++) {
+	char name[8];
+	snprintf(name, sizeof(name), "ch%u", c + 1);
+	statPrint(f, name, &chan[c]);
+    }
+}
+
+void traceIrReport(FILE *f, const std::vector<HalEdge_s> &edges)
+{
+    const uint64_t burstGap = (uint64_t)TRACE_BURST_GAP_US * (F_CPU / 1000000);
+    const uint64_t codeGap = (uint64_t)TRACE_CODE_US * (F_CPU / 1000000);
+
+    TraceStat_s period = {};   // carrier, rising edge to rising edge
+    TraceStat_s burst = {};    // first rising edge to last falling edge
+    TraceStat_s gap = {};      // last falling edge of a burst to the next burst
+    unsigned long codes = 0;
+    unsigned cyclesMin = ~0u, cyclesMax = 0;
+    unsigned burstsMin = ~0u, burstsMax = 0;
+
+    unsigned cycles = 0;       // in the burst so far
+    unsigned bursts = 0;       // in the code so far
+    uint64_t burstStart = 0;
+    uint64_t lastRise = 0;
+    uint64_t lastFall = 0;
+
+    for (size_t e = 0; e <= edges.size(); e++) {
+	bool end = (e == edges.size());
+	uint64_t t = end ? 0 : edges[e].cycle;
+
+	if (!end && !edges[e].level) {
+	    lastFall = t;
+	    continue;
+	}
+
+	if (cycles && (end || (t - lastFall > burstGap))) {
+	    // the burst is over
+	    statAdd(&burst, lastFall - burstStart);
+	    if (cycles < cyclesMin) cyclesMin = cycles;
+	    if (cycles > cyclesMax) cyclesMax = cycles;
+	    bursts++;
+	    cycles = 0;
+
+	    if (end || (t - lastFall > codeGap)) {
+		// and so is the code
+		codes++;
+		if (bursts < burstsMin) burstsMin = bursts;
+		if (bursts > burstsMax) burstsMax = bursts;
+		bursts = 0;
+	    }
+	    else {
+		statAdd(&gap, t - lastFall);
+	    }
+	}
+	if (end) break;
+
+	if (cycles) {
+	    statAdd(&period, t - lastRise);
+	}
+	else {
+	    burstStart = t;
+	}
+	lastRise = t;
+	cycles++;
+    }
+
+    if (!codes) {
+	fprintf(f, "ir: no codes\n");
+	return;
+    }
+
+    fprintf(f, "ir: %lu codes, %u-%u bursts each, %u-%u carrier cycles per burst\n",
+	    codes, burstsMin, burstsMax, cyclesMin, cyclesMax);
+    if (period.count) {
+	fprintf(f, "carrier kHz: min %.2f avg %.2f max %.2f\n",
+		1000 / us(period.max), 1000 / us((double)period.sum / period.count),
+		1000 / us(period.min));
+    }
+    statPrint(f, "burst", &burst);
+    statPrint(f, "gap", &gap);
+}
+
+void traceWiredReport(FILE *f, const std::vector<HalEdge_s> &focus,
+		      const std::vector<HalEdge_s> &shutter)
+{
+    TraceStat_s held = {};     // shutter line
+    TraceStat_s lead = {};     // focus line before the shutter line
+    unsigned long presses = 0;
+    unsigned long unfocused = 0;   // presses without the focus line
+    size_t fe = 0;
+    bool focused = false;
+    uint64_t focusStart = 0;
+    uint64_t pressStart = 0;
+
+    for (size_t e = 0; e < shutter.size(); e++) {
+	uint64_t t = shutter[e].cycle;
+
+	// the focus line up to this edge
+	while ((fe < focus.size()) && (focus[fe].cycle <= t)) {
+	    focused = focus[fe].level;
+	    if (focused) focusStart = focus[fe].cycle;
+	    fe++;
+	}
+
+	if (shutter[e].level) {
+	    presses++;
+	    pressStart = t;
+	    if (focused) {
+		statAdd(&lead, t - focusStart);
+	    }
+	    else {
+		unfocused++;
+	    }
+	}
+	else if (presses) {
+	    statAdd(&held, t - pressStart);
+	}
+    }
+
+    fprintf(f, "wired: %lu presses, %lu without focus\n", presses, unfocused);
+    statPrint(f, "shutter held", &held);
+    statPrint(f, "focus lead", &lead);
+}
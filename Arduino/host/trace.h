@@ -0,0 +1,33 @@
+#pragma once
+
+// Pin 10 (PPM) edge traces from the HAL: export for a waveform viewer, and a
+// report of the PPM timing they show.  Also reports on the shutter trigger's
+// output, from hal_tracePin().
+
+#include <stdio.h>
+
+#include "hal.h"
+
+// A phase longer than this is the sync gap, as a receiver would see it.
+// (The widest channel is 2300uS.)
+#define TRACE_SYNC_US (2500)
+
+// Write the edges as a Value Change Dump, one wire named "ppm".
+void traceVcd(FILE *f, const std::vector<HalEdge_s> &edges);
+
+// Measure frame length, channel widths, sync gap and jitter, and print them.
+void traceReport(FILE *f, const std::vector<HalEdge_s> &edges);
+
+// Between two carrier bursts of an IR code there is less than this, and more
+// than TRACE_BURST_GAP_US.
+#define TRACE_CODE_US (20000)
+#define TRACE_BURST_GAP_US (200)
+
+// Measure the IR codes on an IR LED pin: bursts per code, carrier cycles per
+// burst, carrier frequency, burst length and the gaps in each code.
+void traceIrReport(FILE *f, const std::vector<HalEdge_s> &edges);
+
+// Measure the presses on a wired remote's focus and shutter lines (active HIGH):
+// how long the shutter is held, and how long focus is held before it.
+void traceWiredReport(FILE *f, const std::vector<HalEdge_s> &focus,
+		      const std::vector<HalEdge_s> &shutter);
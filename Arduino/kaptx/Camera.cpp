@@ -0,0 +1,114 @@
+#include "Camera.h"
+#include "Tuning.h"
+
+#include <avr/interrupt.h>
+#include <Arduino.h>
+
+#ifdef CAMERA_PIN
+
+#if (CAMERA_PIN < 8) || (CAMERA_PIN > 13)
+#error CAMERA_PIN must be on port B, pins 8 to 13
+#endif
+#define CAMERA_PCINT (CAMERA_PIN - 8)
+
+struct CameraIn_s {
+    volatile uint8_t count;          // active edges seen
+    volatile unsigned long stamp;    // micros() at the last of them
+    uint8_t level;                   // pin level, to tell the edges apart
+} _camIn;
+
+ISR(PCINT0_vect)
+{
+    uint8_t level = digitalRead(CAMERA_PIN);
+
+    if (level != _camIn.level) {
+	_camIn.level = level;
+	if (level == CAMERA_ACTIVE) {
+	    _camIn.stamp = micros();
+	    _camIn.count++;
+	}
+    }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------------
+// Public API
+
+Camera::Camera()
+{
+    armed = false;
+    more = false;
+    done = false;
+    lastUs = 0;
+    maxUs = 0;
+    signalled = 0;
+    missed = 0;
+}
+
+void Camera::setup()
+{
+#ifdef CAMERA_PIN
+    pinMode(CAMERA_PIN, INPUT_PULLUP);
+    _camIn.level = digitalRead(CAMERA_PIN);
+    _camIn.count = 0;
+
+    PCMSK0 |= _BV(CAMERA_PCINT);
+    PCIFR = _BV(PCIF0);
+    PCICR |= _BV(PCIE0);
+#endif
+}
+
+// Pick up a signal the ISR has seen.
+void Camera::poll()
+{
+#ifdef CAMERA_PIN
+    if (!armed || done) return;
+
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t count = _camIn.count;
+    unsigned long stamp = _camIn.stamp;
+    SREG = sreg;
+
+    if (count != armCount) {
+	done = true;
+	lastUs = stamp - armUs;
+	if (lastUs > maxUs) maxUs = lastUs;
+	if (!more) signalled++;
+    }
+#endif
+}
+
+// The next frame of a burst is pressed before the camera has done with the last,
+// as often as not: that is no miss, so only a shot's last frame (more false)
+// counts in the stats.
+void Camera::arm(bool _more)
+{
+    if (armed && !more && !done) missed++;
+
+#ifdef CAMERA_PIN
+    armCount = _camIn.count;
+#endif
+    armUs = micros();
+    armed = true;
+    more = _more;
+    done = false;
+}
+
+bool Camera::isDone()
+{
+    return done;
+}
+
+void Camera::printStats()
+{
+    Serial.print(F("camera mS last "));
+    Serial.print(lastUs / 1000);
+    Serial.print(F(" max "));
+    Serial.print(maxUs / 1000);
+    Serial.print(F(" shots "));
+    Serial.print(signalled);
+    Serial.print(F(" missed "));
+    Serial.println(missed);
+}
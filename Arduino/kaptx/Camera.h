@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// Optional feedback from the camera on CAMERA_PIN, e.g. a card busy LED or flash
+// sync through an opto, that tells when it has finished a frame.  A pin change
+// interrupt counts the signal's active edges and timestamps them.
+class Camera
+{
+  public:
+    Camera();
+
+    void setup();
+    void poll();
+
+    void arm(bool more);   // shutter pressed: wait for the camera's signal
+    bool isDone();         // the camera has signalled since arm()
+    void printStats();
+
+  private:
+    uint8_t armCount;      // active edges seen before arm()
+    unsigned long armUs;   // time of arm()
+    bool armed;
+    bool more;             // more frames of the shot to come: a burst
+    bool done;
+
+    // Time from arm() to the camera's signal, for tuning TIME_SHUTTER_POST
+    unsigned long lastUs;
+    unsigned long maxUs;
+    unsigned signalled;    // shots the camera signalled, after their last frame
+    unsigned missed;       // and those it didn't
+};
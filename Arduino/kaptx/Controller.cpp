@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include "Tuning.h"
+#include "Motion.h"
 
 // -------------------------------------------------------------------------------------
 // JsController
@@ -320,314 +321,185 @@ bool JsController::isSlidingUD()
 // ShootController
 
 ShootController::ShootController(Model *_model)
+#ifdef PLAN_SHOTS
+    : planner(_model)
+#endif
 {
     model = _model;
+    triggers = 0;
+#ifdef PLAN_SHOTS
+    unplanned = 0;
+#endif
 }
 
 void ShootController::update(bool jsPressed)
 {
-  bool trigger = false;
-  
   if (model->getAuto()) {
     // trigger new sequence when prior one finishes
-    if (model->getShotsQueued() == 0) {
-      trigger = true;
+    if ((model->getShotsQueued() == 0) && (seq.remaining() == 0)) {
+      triggers = 1;
     }
   }
   else {
-    // trigger new sequence when operator presses joystick
-    if (jsPressed) {
-      trigger = true;
+    // trigger new sequence when operator presses joystick.
+    // A press during a sequence starts another when it is done.
+    if (jsPressed && (triggers < 0xff)) {
+      triggers++;
     }
   }
 
-  if (trigger) {
-    // perform shot processing based on mode
-    switch (model->getShootMode()) {
-	case MODE_SINGLE:
-	    shootSingle();
-	    break;
-	case MODE_CLUSTER:
-	    shootCluster();
-	    break;
-	case MODE_VPAN:
-	    shootVpan();
-	    break;
-	case MODE_HPAN:
-	    shootHpan();
-	    break;
-	case MODE_QUAD:
-	    shootQuad();
-	    break;
-	case MODE_360:
-	    shoot360();
-	    break;
-	default:
-	    // reset to single shoot mode
-            model->setDispMode(MODE_SINGLE);
-            model->setModeToDispMode();
-	    break;
-    }
+  if (triggers && (seq.remaining() == 0)) {
+    triggers--;
+    startSequence();
   }
-}
 
-void ShootController::shootSingle()
-{
-    struct PanTilt_s aimPoint;
-    // queue a shot based on current pan/tilt
-    model->getUserPos(&aimPoint);
-    model->queueShot(&aimPoint);
-}
-
-#define SEQ_LEN 7
-
-void ShootController::shootCluster()
-{
-	// queue a sequence of shots
-	struct PanTilt_s aimPointBase;
-        struct PanTilt_s aimPoint;
-
-	// queue a series of shots.
-	static const struct PanTilt_s seq_high[SEQ_LEN] PROGMEM = {
-	    {0, 0}, {1, 1}, {2, 0}, {1, -1}, {-1, -1}, {-2, 0}, {-1, 1},
-	};
-	static const struct PanTilt_s seq_med[SEQ_LEN] PROGMEM = {
-	    {0, 0}, {1, 1}, {2, 0}, {2, -1}, {-2, -1}, {-2, 0}, {-1, 1},
-	};
-	static const struct PanTilt_s seq_low[SEQ_LEN] PROGMEM = {
-	    {0, 0}, {0, 2}, {0, -2}, {4, -2}, {4, 2}, {-4, 2}, {-4, -2},
-	};
-        const struct PanTilt_s *pSeq;
-        
-        // base aim point is user's aim point initially
-	model->getUserPos(&aimPointBase);
-        
-        // get tilt off the rails so cluster doesn't collapse on itself.
-        if (aimPointBase.tilt == TILT_MAX) aimPointBase.tilt -= 1;
-        if (aimPointBase.tilt == TILT_MIN) aimPointBase.tilt += 1;
-        
-        // Choose sequence
-        if (aimPointBase.tilt <= 2) {
-            pSeq = seq_high;
-        }
-        else if (aimPointBase.tilt >= 22) {
-            pSeq = seq_high;
-        }
-        else if (aimPointBase.tilt >= 19) {
-            pSeq = seq_med;
-        }
-        else if (aimPointBase.tilt == 18) {
-            pSeq = seq_low;
-        }
-        else {
-            // use medium cluster pattern, with pan+180, tilt on other side of zenith
-            pSeq = seq_med;
-            aimPointBase.pan = aimPointBase.pan + 12;
-            if (aimPointBase.pan >= 24) aimPointBase.pan -= 24;
-            aimPointBase.tilt = 18 + (18 - aimPointBase.tilt);
-        }
-
-	for (int n = 0; n < SEQ_LEN; n++) {
-            PanTilt_s offset;
-            memcpy_P(&offset, pSeq+n, sizeof(PanTilt_s));
-            
-            aimPoint = aimPointBase;
-            aimPoint.pan = addPan(aimPoint.pan, offset.pan);
-	    aimPoint.tilt = addTilt(aimPoint.tilt, offset.tilt);
-
-            // sprintf(s, "queue shot %d, %d.", aimPoint.pan, aimPoint.tilt);
-            // Serial.println(s);
-            model->queueShot(&aimPoint);
-	}
-}
-
-void ShootController::shootVpan()
-{
-  struct PanTilt_s aimPointBase;
+  // Generate shots as the queue has room for them.
   struct PanTilt_s aimPoint;
-  int tilt;
-  
-    // queue up the userPos position for first shot.
-  model->getUserPos(&aimPointBase);
-  model->queueShot(&aimPointBase);
-    
-    // Try to shoot +/- 45 degrees of tilt around user's tilt
-    // Compute highest tilt
-  tilt = aimPointBase.tilt;
-    
-    // adjust down by 45 degrees (constrained by range of motion)
-    tilt -= 3;  
-    if (tilt < 0) tilt += 23;
-    if (tilt < 15) tilt = 15;
-    
-    // adjust up by 90 degrees (constrained by range of motion)
-    tilt += 6;
-    if (tilt >= 24) tilt -= 24;
-    if ((tilt > TILT_MAX) && (tilt < TILT_MIN)) tilt = TILT_MAX;
-   
-    // Take shots spanning 90 degrees
-    for (int n = 0; n < 7; n++) {
-	aimPoint.pan = aimPointBase.pan;
-      aimPoint.tilt = tilt - n;
-      if (aimPoint.tilt < 0) aimPoint.tilt += 24;
-      model->queueShot(&aimPoint);
-    }
+  bool vert;
+  while ((model->getShotsQueued() < SHOT_QUEUE_LEN) && seq.next(&aimPoint, &vert)) {
+    model->queueShot(&aimPoint, seq.frames(), vert);
+#ifdef PLAN_SHOTS
+    unplanned++;
+#endif
+  }
+  model->setShotsPending(seq.remaining());
+
+#ifdef PLAN_SHOTS
+  // Plan a full queue, and the end of a sequence.  Not for each shot added as
+  // the queue drains: planning takes a while.
+  if (unplanned &&
+      ((unplanned >= SHOT_QUEUE_LEN/4) || (seq.remaining() == 0))) {
+    planner.start();
+    unplanned = 0;
+  }
+  planner.step();
+#endif
 }
 
-void ShootController::shootHpan()
+void ShootController::startSequence()
 {
-    struct PanTilt_s aimPointBase;
-  struct PanTilt_s aimPoint;
-  int tilt;
-  int tilt2;
-
-  model->getUserPos(&aimPointBase);
-  tilt = aimPointBase.tilt;
-  tilt2 = ((tilt <= 2) || (tilt > 18)) ? tilt-2 : tilt + 2;
-  
-  if (tilt2 < 0) tilt2 += 24;
-  
-    // queue up the userPos position for first shot.
-  aimPoint = aimPointBase;
-    model->queueShot(&aimPoint);
-       
-    // Take shots 45 degrees left to 45 right, two rows
-    for (int n = -3; n <= 3; n += 2) {
-	aimPoint.pan = aimPointBase.pan + n; 
-      if (aimPoint.pan < 0) aimPoint.pan += 24;
-      if (aimPoint.pan >= 24) aimPoint.pan -= 24;
-      aimPoint.tilt = tilt;
-      model->queueShot(&aimPoint);
-      
-      aimPoint.tilt = tilt2;
-      model->queueShot(&aimPoint);
-    }
+  struct PanTilt_s userPos;
+  Mode_t mode = model->getShootMode();
+
+  if (mode >= NUM_MODES) {
+    // reset to single shoot mode
+    model->setDispMode(MODE_SINGLE);
+    model->setModeToDispMode();
+    return;
+  }
+
+  // shot pattern based on mode, around the current pan/tilt
+  model->getUserPos(&userPos);
+  seq.start(mode, &userPos, model->getHoVer());
 }
 
-void ShootController::shootQuad()
+// -------------------------------------------------------------------------------------
+// SlewController
+
+#define SLEW_STABLE (0)
+#define SLEW_MOVING (1)
+#define SLEW_STABILIZING (2)
+
+// Most missed frames the servos will be stepped through in one update.
+#define SLEW_CATCHUP_MAX (10)
+
+// STABILIZING_FULL_VEL, per tick
+#define STABILIZING_FULL_VEL_TICK ((unsigned)(STABILIZING_FULL_VEL * MOTION_TICK))
+
+static_assert(SCURVE_MAX <= 16, "a JERK_ limit is too low for its ACCEL_");
+
+static void scurveReset(struct SlewAxis_s *axis, long pos)
 {
-  static const struct PanTilt_s quadSeq[] PROGMEM = {
-    {-3, 0}, {-3, -2}, {-3, -4}, {-3, -6},
-    {-1, 0}, {-1, -2},
-    { 0, -4},
-    { 1, -2}, { 1, 0}, 
-    { 3, 0}, {3, -2}, {3, -4}, {3, -6},
-  };
-  
-  struct PanTilt_s reference;
-  struct PanTilt_s aimPoint;
-  
-  model->getUserPos(&reference);
-    reference.tilt = 0;
-    for (int n = 0; n < sizeof(quadSeq)/sizeof(quadSeq[0]); n++) {
-      PanTilt_s offset;
-      memcpy_P(&offset, quadSeq+n, sizeof(PanTilt_s));
-      aimPoint = reference;
-      aimPoint.pan = addPan(aimPoint.pan, offset.pan);
-      aimPoint.tilt = addTilt(aimPoint.tilt, offset.tilt);
-      model->queueShot(&aimPoint);
+    axis->pos = pos;
+    axis->vel = 0;
+    axis->sum = 0;
+    axis->lag = 0;
+    for (uint8_t i = 0; i < SCURVE_MAX; i++) {
+	axis->hist[i] = 0;
     }
+    axis->next = 0;
 }
 
-void ShootController::shoot360()
+// Take in the slew's latest step, and move the servo on: to the mean of the
+// last n slew positions.  That is the slew position less the lag, which is kept
+// up exactly so the servo lands on the slew's final position.
+static void scurve(struct SlewAxis_s *axis, uint8_t n, long step, long *pos, long *vel)
 {
-  static const struct PanTilt_s seq360[] PROGMEM = {
-    { 0, 0}, { 0, -2}, { 0, -4}, { 0, -6},
-    { 2, 0}, { 2, -2},
-    { 3, -4},
-    { 4, -2}, { 4, 0}, 
-  };
-  
-  struct PanTilt_s reference;
-  struct PanTilt_s aimPoint;
-  
-    for (int i = 0; i < 4; i++) {   // shoot 4 quadrants
-	model->getUserPos(&reference);
-      reference.tilt = 0;
-      reference.pan = addPan(reference.pan, i*6);
-      for (int n = 0; n < sizeof(seq360)/sizeof(seq360[0]); n++) {
-        PanTilt_s offset;
-        memcpy_P(&offset, seq360+n, sizeof(PanTilt_s));
-        aimPoint = reference;
-        aimPoint.pan = addPan(aimPoint.pan, offset.pan);
-        aimPoint.tilt = addTilt(aimPoint.tilt, offset.tilt);
-        model->queueShot(&aimPoint);
-      }
+    if (n == 1) {
+	// no filter
+	*pos = axis->pos;
+	*vel = axis->vel;
+	return;
     }
-}
 
-int ShootController::addPan(int pan, int n)
-{
-  pan += n;
-  if (pan < 0) pan += ANG_360;
-  if (pan >= ANG_360) pan -= ANG_360;
-  
-  return pan;
-}
+    axis->lag += (long)(n - 1) * step - axis->sum;
+    axis->sum += step - axis->hist[axis->next];
+    axis->hist[axis->next] = step;
+    if (++axis->next == n - 1) axis->next = 0;
 
-int ShootController::addTilt(int tilt, int n)
-{
-  tilt += n;
-  if (tilt >= ANG_360) tilt -= ANG_360;
-  if (tilt < 0) tilt += ANG_360;
-  
-  if ((tilt > TILT_MAX) && (tilt < TILT_MID_DEAD)) tilt = TILT_MAX;
-  if ((tilt < TILT_MIN) && (tilt >= TILT_MID_DEAD)) tilt = TILT_MIN;
-  
-  return tilt;
+    long out = axis->pos - axis->lag / n;
+    *vel = out - *pos;
+    *pos = out;
 }
 
-// -------------------------------------------------------------------------------------
-// SlewController
-
-#define SLEW_STABLE (0)
-#define SLEW_MOVING (1)
-#define SLEW_STABILIZING (2)
-
-#define ACCEL_PAN (1)
-#define ACCEL_TILT (1)
-
 SlewController::SlewController(Model *_model)
 {
     model = _model;
     state = SLEW_STABLE;
-    timer = 0;
+    start = 0;
+    lastTick = 0;
+    wait = TIME_STABILIZING_MAX;
+    moveSize = 0;
+    movePeak = 0;
+    goal.pan = 0;
+    goal.tilt = 0;
+    goalHoVer = 0;
+    cruise.pan = VMAX_PAN_Q8;
+    cruise.tilt = VMAX_TILT_Q8;
+    cruiseHoVer = VMAX_HOVER_Q8;
+    scurveReset(&pan, 0);
+    scurveReset(&tilt, 0);
+    scurveReset(&hover, 0);
 }
 
-bool SlewController::update(bool shutterIdle)
+bool SlewController::update(bool shutterClear, uint16_t tick)
 {
+    // Frames since the last update: normally 1, more if loop() overran.
+    uint16_t steps = tick - lastTick;
+    lastTick = tick;
+    if (steps > SLEW_CATCHUP_MAX) steps = SLEW_CATCHUP_MAX;
+
     // execute slew state machine to bring servos to target position.
     switch (state) {
 	case SLEW_STABLE:
 	    // Serial.println("slew state STABLE");
-	    if (shutterIdle &&
+	    if (shutterClear &&
 		(!model->atGoalPos())) {
 		// start moving
 		state = SLEW_MOVING;
-		moveServos();
+		startMove();
+		moveServos(1);
 	    }
 	    break;
 	case SLEW_MOVING:
 	    // Serial.println("slew state MOVING");
-	    if (!model->atGoalPos()) {
-		moveServos();
+	    if (!atGoal()) {
+		// step through any frames that were missed as well
+		moveServos(steps);
 	    } else {
-		timer = TIME_STABILIZING;
+		start = tick;
+		wait = stabilizeTime();
 		state = SLEW_STABILIZING;
 	    }
 	    break;
 	case SLEW_STABILIZING:
 	    // Serial.println("slew state STABILIZING");
-	    if (!model->atGoalPos()) {
-		timer = 0;
+	    if (!atGoal()) {
 		state = SLEW_MOVING;
-		moveServos();
+		moveServos(1);
 	    }
-	    else if (timer > 0) {
-		// Wait for slew stabilization time
-		timer--;
-	    } else {
-		// waiting is done, we're stable
+	    else if (ticksSince(tick, start) > wait) {
+		// waiting for slew stabilization time is done, we're stable
 		state = SLEW_STABLE;
 	    }
 	    break;
@@ -639,13 +511,15 @@ bool SlewController::update(bool shutterIdle)
     }
 
     model->setSlewStable(state == SLEW_STABLE);
+
+    return state == SLEW_STABLE;
 }
 
-void SlewController::slew(int *x, int *v, int target, int a)
+void SlewController::slew(long *x, long *v, long target, unsigned a, unsigned vmax)
 {
     // compute position error
-    int deltax = target - *x;
-    int norm_v = *v;
+    long deltax = target - *x;
+    long norm_v = *v;
     bool reverse = false;
     if (deltax < 0) {
 	reverse = true;
@@ -653,28 +527,24 @@ void SlewController::slew(int *x, int *v, int target, int a)
 	norm_v = -norm_v;
     }
 
-    // compute limiting velocity
-    int v_limit = 0;
-    int dist = 0;
-    while (dist < deltax) {
-	v_limit += a;
-	dist += v_limit;
-    }
+    // fastest we can be going and still stop on target
+    long v_limit = brakeLimit(deltax, a);
 
-    if ((deltax <= a) && (norm_v <= a) && (norm_v >= -a)) {
+    if ((deltax <= a) && (norm_v <= a) && (norm_v >= -(long)a)) {
 	// hit the target and stop
 	*x = target;
 	*v = 0;
     } 
     else {
-	if (norm_v + a < v_limit) {
-	    // accelerate
-	    norm_v += a;
-	}
-	else {
-	    // decelerate
-	    norm_v -= a;
-	}
+	// Accelerate by a, up to the top speed and to a below the braking
+	// limit.  Velocities need not be multiples of a, so this also joins
+	// the braking curve smoothly.  Decelerate by a at most.
+	long next = norm_v + a;
+	if (next > (long)vmax) next = vmax;
+	if (next > v_limit - (long)a) next = v_limit - a;
+	if (next < norm_v - (long)a) next = norm_v - a;
+	norm_v = next;
+
 	if (!reverse) {
 	    *x += norm_v;
 	    *v = norm_v;
@@ -686,38 +556,187 @@ void SlewController::slew(int *x, int *v, int target, int a)
     }
 }
 
-void SlewController::moveServos()
+// Start the slew from where the servos are, at rest.
+void SlewController::startMove()
 {
-    // update servo target position from userPos
-    struct PanTilt_s goal;
-    struct PanTilt_s pos;
-    struct PanTilt_s vel;
+    PanTiltQ8_t pos;
+    PanTiltQ8_t vel;
+    long hoVerPos;
+    long hoVerVel;
 
-    model->getGoalPwm(&goal);
+    model->getServos(&pos, &vel);
+    model->getHoVerServo(&hoVerPos, &hoVerVel);
+    scurveReset(&pan, pos.pan);
+    scurveReset(&tilt, pos.tilt);
+    scurveReset(&hover, hoVerPos);
+    moveSize = 0;
+    movePeak = 0;
+}
+
+// Set each axis' top speed for a move from where the slew is to the goal.  The
+// axes that would get there before the slowest are slowed, so all arrive together.
+void SlewController::planMove()
+{
+    unsigned long dPan = labs(Q8(goal.pan) - pan.pos);
+    unsigned long dTilt = labs(Q8(goal.tilt) - tilt.pos);
+    unsigned long dHoVer = labs(Q8(goalHoVer) - hover.pos);
+    unsigned tPan = moveTicks(dPan, ACCEL_PAN_Q8, VMAX_PAN_Q8) + SCURVE_PAN;
+    unsigned tTilt = moveTicks(dTilt, ACCEL_TILT_Q8, VMAX_TILT_Q8) + SCURVE_TILT;
+    unsigned tHoVer = moveTicks(dHoVer, ACCEL_HOVER_Q8, VMAX_HOVER_Q8) + SCURVE_HOVER;
+    unsigned t = tPan;
+
+    if (tTilt > t) t = tTilt;
+    if (tHoVer > t) t = tHoVer;
+
+    if (dPan > Q8(moveSize)) moveSize = dPan >> 8;
+    if (dTilt > Q8(moveSize)) moveSize = dTilt >> 8;
+    if (dHoVer > Q8(moveSize)) moveSize = dHoVer >> 8;
+
+    cruise.pan = VMAX_PAN_Q8;
+    cruise.tilt = VMAX_TILT_Q8;
+    cruiseHoVer = VMAX_HOVER_Q8;
+    if (tPan < t) {
+	cruise.pan = cruiseFor(dPan, ACCEL_PAN_Q8, VMAX_PAN_Q8, t - SCURVE_PAN);
+    }
+    if (tTilt < t) {
+	cruise.tilt = cruiseFor(dTilt, ACCEL_TILT_Q8, VMAX_TILT_Q8, t - SCURVE_TILT);
+    }
+    if (tHoVer < t) {
+	cruiseHoVer = cruiseFor(dHoVer, ACCEL_HOVER_Q8, VMAX_HOVER_Q8, t - SCURVE_HOVER);
+    }
+}
+
+// Ticks to stabilize for after the moves since the servos were last stable:
+// TIME_STABILIZING_MIN to TIME_STABILIZING_MAX, by the move's size or peak
+// velocity, whichever is nearer full scale.
+uint8_t SlewController::stabilizeTime()
+{
+    // fractions of full scale, in 1/256ths
+    unsigned long size = Q8(moveSize) / STABILIZING_FULL_PWM;
+    unsigned long peak = movePeak / STABILIZING_FULL_VEL_TICK;
+    unsigned long scale = (size > peak) ? size : peak;
+
+    if (scale > Q8_ONE) scale = Q8_ONE;
+    return TIME_STABILIZING_MIN +
+	(((TIME_STABILIZING_MAX - TIME_STABILIZING_MIN) * scale) >> 8);
+}
+
+// Ticks for one axis to get from pos to target, going at vel now: roughly, as
+// if it cruised at vel then braked.
+static unsigned ticksToGo(long pos, long vel, long target, unsigned a, unsigned vmax)
+{
+    unsigned long d = labs(target - pos);
+
+    if ((target > pos) ? (vel <= 0) : (vel >= 0)) {
+	// still, or going the wrong way
+	return moveTicks(d, a, vmax);
+    }
+    unsigned long v = labs(vel);
+    return d / v + v / (2 * a);
+}
+
+// Rough ticks until the servos are stable on the goal: to finish the move, let
+// the S-curve run out, and stabilize.  0 once stable.
+uint16_t SlewController::ticksToStable()
+{
+    PanTilt_t to;
+    unsigned t;
+    unsigned tTilt;
+    unsigned tHoVer;
+
+    switch (state) {
+	case SLEW_STABILIZING:
+	    t = ticksSince(lastTick, start);
+	    return (t < wait) ? wait - t : 0;
+	case SLEW_STABLE:
+	    if (model->atGoalPos()) return 0;
+	    break;
+	default:
+	    break;
+    }
+
+    model->getGoalPwm(&to);
+    t = ticksToGo(pan.pos, pan.vel, Q8(to.pan), ACCEL_PAN_Q8, VMAX_PAN_Q8) + SCURVE_PAN;
+    tTilt = ticksToGo(tilt.pos, tilt.vel, Q8(to.tilt), ACCEL_TILT_Q8, VMAX_TILT_Q8) + SCURVE_TILT;
+    tHoVer = ticksToGo(hover.pos, hover.vel, Q8(model->getGoalHoVerPwm()),
+		       ACCEL_HOVER_Q8, VMAX_HOVER_Q8) + SCURVE_HOVER;
+    if (tTilt > t) t = tTilt;
+    if (tHoVer > t) t = tHoVer;
+
+    return t + stabilizeTime();
+}
+
+// Servos on the goal and still, with the S-curve filters run out.
+bool SlewController::atGoal()
+{
+    return (model->atGoalPos() &&
+	    (pan.vel == 0) && (pan.sum == 0) && (pan.lag == 0) &&
+	    (tilt.vel == 0) && (tilt.sum == 0) && (tilt.lag == 0) &&
+	    (hover.vel == 0) && (hover.sum == 0) && (hover.lag == 0));
+}
+
+void SlewController::moveServos(unsigned steps)
+{
+    // update servo target position from userPos
+    struct PanTilt_s next;
+    struct PanTiltQ8_s pos;
+    struct PanTiltQ8_s vel;
+    int nextHoVer;
+    long hoVerPos;
+    long hoVerVel;
 
     // TODO-DW : Keep pos, vel in controller, set pos in model as output
-    // TODO-DW : Incorporate HoVer servo into slew controller
 
     model->getServos(&pos, &vel);
+    model->getHoVerServo(&hoVerPos, &hoVerVel);
+
+    model->getGoalPwm(&next);
+    nextHoVer = model->getGoalHoVerPwm();
+    if ((next.pan != goal.pan) || (next.tilt != goal.tilt) || (nextHoVer != goalHoVer)) {
+	goal = next;
+	goalHoVer = nextHoVer;
+	planMove();
+    }
+
+    for (unsigned n = 0; n < steps; n++) {
+	long panFrom = pan.pos;
+	long tiltFrom = tilt.pos;
+	long hoVerFrom = hover.pos;
+
+	slew(&pan.pos, &pan.vel, Q8(goal.pan), ACCEL_PAN_Q8, cruise.pan);
+	slew(&tilt.pos, &tilt.vel, Q8(goal.tilt), ACCEL_TILT_Q8, cruise.tilt);
+	slew(&hover.pos, &hover.vel, Q8(goalHoVer), ACCEL_HOVER_Q8, cruiseHoVer);
+
+	scurve(&pan, SCURVE_PAN, pan.pos - panFrom, &pos.pan, &vel.pan);
+	scurve(&tilt, SCURVE_TILT, tilt.pos - tiltFrom, &pos.tilt, &vel.tilt);
+	scurve(&hover, SCURVE_HOVER, hover.pos - hoVerFrom, &hoVerPos, &hoVerVel);
 
-    slew(&pos.pan, &vel.pan, goal.pan, ACCEL_PAN);
-    slew(&pos.tilt, &vel.tilt, goal.tilt, ACCEL_TILT);
+	if (labs(vel.pan) > movePeak) movePeak = labs(vel.pan);
+	if (labs(vel.tilt) > movePeak) movePeak = labs(vel.tilt);
+	if (labs(hoVerVel) > movePeak) movePeak = labs(hoVerVel);
+    }
     
     model->setServos(&pos, &vel);
+    model->setHoVerServo(hoVerPos, hoVerVel);
 }
 
 // -------------------------------------------------------------------------------------
 // ShutterController
 
-ShutterController::ShutterController(Model *_model)
+ShutterController::ShutterController(Model *_model, Camera *_camera, Trigger *_trigger)
 {
   model = _model;
+  camera = _camera;
+  trigger = _trigger;
   state = SHUTTER_IDLE;
+  start = 0;
+  frames = 0;
 
   model->setShutterState(state);
 }
 
-void ShutterController::update()
+// slewEta: ticks until the rig is due to be stable
+void ShutterController::update(uint16_t tick, uint16_t slewEta)
 {
     switch (state) {
 	case SHUTTER_IDLE:
@@ -731,34 +750,58 @@ void ShutterController::update()
 	    // Serial.println("shutter state TRIGGERED");
 	    if (model->getSlewStable()) {
 		// trip shutter and transition to DOWN state
-		model->setShutter(true);
-		timer = TIME_SHUTTER_DOWN;
-		state = SHUTTER_DOWN;
-		// Serial.println("shutter state DOWN");
+		frames = SHOT_FRAMES(model->getShot(0));
+		press(tick);
+	    }
+	    else {
+		halfPress(slewEta);
 	    }
 	    break;
 	case SHUTTER_DOWN:
 	    // Serial.println("shutter state DOWN");
-	    if (timer > 0) {
-		timer--;
-	    } else {
-		// shutter has been down long enough
+	    if (ticksSince(tick, start) > trigger->pressTicks()) {
+		// shutter has been down long enough.  Stay focused for the rest
+		// of a burst.
 		model->setShutter(false);
-		timer = TIME_SHUTTER_POST;
+		model->setShutterHalf((frames > 1) && trigger->canHalfPress());
+		start = tick;
 		state = SHUTTER_POST;
 		// Serial.println("shutter state POST");
 	    }
 	    break;
 	case SHUTTER_POST:
 	    // Serial.println("shutter state POST");
-	    if (timer > 0) {
-		timer--;
-	    } else {
-		// shutter has been up long enough
+	    if (frames > 1) {
+		// next frame of the burst: the rig hasn't moved
+		if (ticksSince(tick, start) > TIME_BURST_GAP) {
+		    frames--;
+		    press(tick);
+		}
+		break;
+	    }
+	    // The camera's signal can come while the shutter is still open (flash
+	    // sync), so it only ends the wait once the exposure is over, in BUSY.
+	    if (ticksSince(tick, start) > TIME_SHUTTER_EXPOSED) {
+		// exposure is over: on to the next shot while the camera finishes
 		model->dequeueShot();
+		state = SHUTTER_BUSY;
+	    }
+	    else {
+		break;
+	    }
+	    // fall through
+	case SHUTTER_BUSY:
+	    // Serial.println("shutter state BUSY");
+	    if (camera->isDone() ||
+		(ticksSince(tick, start) > TIME_SHUTTER_POST)) {
+		// camera is done, or shutter has been up long enough
 		state = SHUTTER_IDLE;
 		// Serial.println("shutter state IDLE");
 	    }
+	    else if (model->getShotsQueued()) {
+		// the rig is on its way to the next shot
+		halfPress(slewEta);
+	    }
 	    break;
 	default:
 	    // Serial.println("Bogus shutter state!");
@@ -774,21 +817,46 @@ bool ShutterController::isIdle()
   return state == SHUTTER_IDLE;
 }
 
+// Trip the shutter, for one frame.
+void ShutterController::press(uint16_t tick)
+{
+    model->setShutter(true);
+    camera->arm(frames > 1);
+    start = tick;
+    state = SHUTTER_DOWN;
+    // Serial.println("shutter state DOWN");
+}
+
+// Half press, to focus, once the rig is nearly stable.
+void ShutterController::halfPress(uint16_t slewEta)
+{
+    if (trigger->canHalfPress() && (slewEta <= TIME_SHUTTER_HALF_LEAD)) {
+	model->setShutterHalf(true);
+    }
+}
+
+// The rig may slew: no shot is being taken, or its exposure is over.
+bool ShutterController::canMove()
+{
+  return (state == SHUTTER_IDLE) || (state == SHUTTER_BUSY);
+}
+
 // -------------------------------------------------------------------------------------
 // Controller
 
-Controller::Controller(Joystick *_js, Model *_model) :
+Controller::Controller(Joystick *_js, Camera *_camera, Trigger *_trigger, Model *_model) :
     jsc(_js, _model),
     shoot(_model),
     slew(_model),
-    shutter(_model)
+    shutter(_model, _camera, _trigger)
 {
     js = _js;
+    trigger = _trigger;
     model = _model;
 }
 
 // Controller actions
-void Controller::update()
+void Controller::update(uint16_t tick)
 {
     bool slewStable;
     bool jsPressed;
@@ -796,6 +864,7 @@ void Controller::update()
     // Update each controller component
     jsPressed = jsc.update();
     shoot.update(jsPressed);
-    slew.update(shutter.isIdle());
-    shutter.update();
+    slew.update(shutter.canMove(), tick);
+    // The slew's ETA is only for a half press, and takes divides to work out.
+    shutter.update(tick, trigger->canHalfPress() ? slew.ticksToStable() : 0);
 }
@@ -1,7 +1,15 @@
 #pragma once 
 
+#include <stdint.h>
+
 #include "Joystick.h"
+#include "Camera.h"
+#include "Trigger.h"
 #include "Model.h"
+#include "Sequence.h"
+#include "Planner.h"
+#include "Motion.h"
+#include "Tuning.h"
 
 
 
@@ -44,6 +52,12 @@ class ShootController
   private:
     // Instance data
     Model *model;
+    ShotSequence seq;
+    unsigned char triggers;   // sequences triggered but not started yet
+#ifdef PLAN_SHOTS
+    Planner planner;
+    unsigned char unplanned;  // shots queued since the planner last ran
+#endif
 
   public:
     // Public API
@@ -51,16 +65,18 @@ class ShootController
 
   private:
     // Utility methods
-    void shootSingle();
-    bool isValidPanTilt(struct PanTilt_s *pt);
-    void shootCluster();
-    void shootVpan();
-    void shootHpan();
-    void shootQuad();
-    void shoot360();
-    int addPan(int pan, int n);
-    int addTilt(int tilt, int n);
+    void startSequence();
+};
 
+// One axis of the slew, and the moving average that eases it into an S-curve:
+// the servo goes to the mean of the last n slew positions.
+struct SlewAxis_s {
+    long pos;              // slew position, Q8
+    long vel;              // slew velocity, Q8
+    long sum;              // sum of the last n-1 steps
+    long lag;              // how far the servo trails pos, times n
+    int hist[SCURVE_MAX];  // the last n-1 steps the slew took
+    uint8_t next;          // oldest of them
 };
 
 class SlewController
@@ -72,16 +88,32 @@ class SlewController
     Model *model;
 
     unsigned char state;
-    unsigned int timer;
+    uint16_t start;        // tick stabilizing started
+    uint16_t lastTick;     // tick of previous update
+    uint8_t wait;          // ticks to stabilize for
+    unsigned moveSize;     // longest axis move since stable, PWM units
+    unsigned movePeak;     // fastest servo velocity since stable, Q8
+    PanTilt_t goal;        // goal the move was planned for
+    int goalHoVer;
+    PanTilt_t cruise;      // top speed of each axis for this move, Q8
+    unsigned cruiseHoVer;
+    struct SlewAxis_s pan;
+    struct SlewAxis_s tilt;
+    struct SlewAxis_s hover;
 
   public:
     // Public API
-    bool update(bool shutterIdle);
+    bool update(bool shutterClear, uint16_t tick);  // shutterClear: the rig may move
+    uint16_t ticksToStable();
 
   private:
     // Utility methods
-    void slew(int *x, int *v, int target, int a);
-    void moveServos();
+    void slew(long *x, long *v, long target, unsigned a, unsigned vmax);
+    void startMove();
+    void planMove();
+    bool atGoal();
+    uint8_t stabilizeTime();
+    void moveServos(unsigned steps);
 };
 
 // Shutter controller states
@@ -89,31 +121,42 @@ class SlewController
 #define SHUTTER_TRIGGERED (1)
 #define SHUTTER_DOWN (2)
 #define SHUTTER_POST (3)
+#define SHUTTER_BUSY (4)      // exposure over, camera still busy: the rig may move
 
 class ShutterController
 {
   public:
-    ShutterController(Model *_model);
+    ShutterController(Model *_model, Camera *_camera, Trigger *_trigger);
 
   private:
     Model *model;
+    Camera *camera;
+    Trigger *trigger;
     unsigned char state;
-    unsigned int timer;
+    uint16_t start;        // tick the current state started
+    uint8_t frames;        // frames left to take at this shot, this one included
 
   public:
     // Public API
-    void update();
+    void update(uint16_t tick, uint16_t slewEta);
     bool isIdle();
+    bool canMove();
+
+  private:
+    // Utility methods
+    void press(uint16_t tick);
+    void halfPress(uint16_t slewEta);
 };
 
 class Controller
 {
   public:
-    Controller(Joystick *js, Model *model);
+    Controller(Joystick *js, Camera *camera, Trigger *trigger, Model *model);
 
   private:
     // Instance data
     Joystick *js;
+    Trigger *trigger;
     Model *model;
 
     JsController jsc;
@@ -123,7 +166,8 @@ class Controller
 
   public:
     // Public methods
-    void update();
+    // tick is the PPM frame number; controller timing is measured against it.
+    void update(uint16_t tick);
 
   private:
     // Utility methods
@@ -1,22 +1,177 @@
 #include "Joystick.h"
 #include "Tuning.h"
+#include "Motion.h"
 
+#include <avr/interrupt.h>
 #include <Arduino.h>
 
-#define JS_DEBOUNCE (5)
+#define JS_DEBOUNCE FRAMES_MS(100)
 #define JS_MID (512)
 #define JS_MAX (1023)
 
+// Once a frame, poll() starts a burst of conversions: the ADC interrupt converts
+// JS_OVERSAMPLE readings of X, then of Y, in the background, and averages each
+// into one sample.  A conversion takes 104uS, so the pair is ready about 0.8mS
+// later, for the next poll().  The ADC then stops until that poll(), so it wakes
+// the CPU from its sleep in Ppm::sync() only those 8 times a frame.
+#define JS_OVERSAMPLE (4)   // a power of two
+
+// Values for ADC registers
+#define ADMUX_AVCC (0x40)   // AVcc reference, result right adjusted
+#define ADPS_DIV128 (0x07)  // ADC clock 125kHz: full 10 bit accuracy at 16MHz
+
 #define JS_NEUTRAL (350) // (450)
 #define JS_PLUS (400) // (500)
 
-#define TAN_37_5 (0.76732699)
-#define TAN_33_75 (0.66817864)
-#define TAN_22_5 (0.41421356)
-#define TAN_11_25 (0.19891237)
-#define TAN_7_5 (0.13165250)
+// Sector boundaries within the first octant (0-45 degrees), as exact slopes:
+// a folded stick position is past a boundary when y/x > num/den.
+// These give the same result as the float compare of y/x against tan(angle) they
+// replace, rounding included, for every x, y the ADC can produce.  (Found by
+// exhaustive search against IEEE single precision, which is what avr-gcc uses.)
+struct JsSlope_s {
+    uint16_t num;
+    uint16_t den;
+};
+
+static const struct JsSlope_s slopes24[] PROGMEM = {
+    { 99, 752 },    // tan(7.5)
+    { 239, 577 },   // tan(22.5)
+    { 498, 649 },   // tan(37.5)
+};
+
+static const struct JsSlope_s slopes16[] PROGMEM = {
+    { 239, 577 },   // tan(22.5)
+};
+
+static const struct JsSlope_s slopes16_offs[] PROGMEM = {
+    { 110, 553 },   // tan(11.25)
+    { 443, 663 },   // tan(33.75)
+};
+
+// Map x, y into SECTORS sectors, in standard orientation (0 is due "east",
+// numbered anticlockwise).  If CENTERED, sector 0 is centered on east and each
+// octant holds SECTORS/8 boundaries, otherwise sector 0 starts at east and
+// there is one boundary fewer.
+// x, y are folded into the first octant, the boundaries passed are counted,
+// and the folds are undone.  No division: |x|, |y| <= 512, so the products
+// fit a long.
+template <uint8_t SECTORS, bool CENTERED, uint8_t BOUNDS>
+static int sectorIndex(int x, int y, const struct JsSlope_s (&slope)[BOUNDS])
+{
+    static_assert(BOUNDS == SECTORS/8 - (CENTERED ? 0 : 1), "wrong number of sector boundaries");
+    const int off = CENTERED ? 0 : 1;
+    int index = 0;
+    bool fold_y = false;
+    bool fold_x = false;
+    bool fold_xy = false;
+    int tmp;
+
+    // fold x, y into 0, 1 positions
+    if (y < 0) {
+	fold_x = true;
+	y = -y;
+    }
+    if (x < 0) {
+	fold_y = true;
+	x = -x;
+    }
+    if (y > x) {
+	fold_xy = true;
+	tmp = x;
+	x = y;
+	y = tmp;
+    }
+
+    // boundaries are in increasing order
+    while ((index < BOUNDS) &&
+	   ((unsigned long)y * pgm_read_word(&slope[index].den) >
+	    (unsigned long)x * pgm_read_word(&slope[index].num))) {
+	index++;
+    }
+
+    // unfold as necessary
+    if (fold_xy) index = SECTORS/4 - off - index;
+    if (fold_y) index = SECTORS/2 - off - index;
+    if (fold_x) index = SECTORS - off - index;
+    if (index == SECTORS) index = 0;
+
+    return index;
+}
+
+// ---------------------------------------------------------------------------------
+
+struct JsAdc_s {
+    uint8_t chan[2];                // ADC channels for X and Y
+    uint8_t axis;                   // axis being converted, 0 = X
+    uint8_t count;                  // readings summed so far
+    uint16_t sum;
+
+    // Double buffered samples.  The ISR fills sample[bank^1], and flips bank when
+    // it holds a complete pair.
+    volatile uint16_t sample[2][2];
+    volatile uint8_t bank;
+    volatile bool busy;             // a burst is running
+} _jsAdc;
+
+// Point the ADC at a channel (as analogRead() does).
+static void adcSelect(uint8_t chan)
+{
+#if defined(MUX5)
+    ADCSRB = (ADCSRB & ~_BV(MUX5)) | (((chan >> 3) & 0x01) << MUX5);
+#endif
+    ADMUX = ADMUX_AVCC | (chan & 0x07);
+}
+
+// ADC channel of an analog pin, A0 or 0 both being channel 0.
+static uint8_t adcChannel(uint8_t pin)
+{
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    if (pin >= 54) pin -= 54;
+#else
+    if (pin >= 14) pin -= 14;
+#endif
+    return pin;
+}
+
+ISR(ADC_vect)
+{
+    _jsAdc.sum += ADCW;
+
+    if (++_jsAdc.count == JS_OVERSAMPLE) {
+	uint8_t back = _jsAdc.bank ^ 1;
+
+	_jsAdc.sample[back][_jsAdc.axis] = (_jsAdc.sum + JS_OVERSAMPLE/2) / JS_OVERSAMPLE;
+	_jsAdc.sum = 0;
+	_jsAdc.count = 0;
+
+	_jsAdc.axis ^= 1;
+	if (_jsAdc.axis == 0) {
+	    // Y done too: publish the pair, and stop until the next poll()
+	    _jsAdc.bank = back;
+	    _jsAdc.busy = false;
+	    return;
+	}
+	adcSelect(_jsAdc.chan[_jsAdc.axis]);
+    }
 
+    // start the next conversion
+    ADCSRA |= _BV(ADSC);
+}
+
+// Start a burst: X, then Y.
+static void adcStart()
+{
+    _jsAdc.axis = 0;
+    _jsAdc.count = 0;
+    _jsAdc.sum = 0;
+    _jsAdc.busy = true;
+    adcSelect(_jsAdc.chan[0]);
+    ADCSRA |= _BV(ADSC);
+}
+
+// ---------------------------------------------------------------------------------
 // Public API
+
 Joystick::Joystick()
 {
   // Save params
@@ -32,28 +187,49 @@ void Joystick::setup()
 
     but = false;
     pressed = false;
-    debounce = 0;
+    debounce = false;
+
+    // Centered until the first samples are in.
+    for (unsigned n = 0; n < 2; n++) {
+	_jsAdc.sample[n][0] = JS_MID;
+	_jsAdc.sample[n][1] = JS_MID;
+    }
+    _jsAdc.bank = 0;
+    _jsAdc.chan[0] = adcChannel(x_pin);
+    _jsAdc.chan[1] = adcChannel(y_pin);
+
+    // Enable the ADC, and take the first samples.
+    ADCSRA = _BV(ADEN) | _BV(ADIE) | ADPS_DIV128;
+    adcStart();
 }
 
-void Joystick::poll()
+void Joystick::poll(uint16_t tick)
 {
     bool oldbut = but;
 
-    // Read input signals and convert to x, y.
-    x = JS_DIR_X * (JS_MID - analogRead(x_pin));
-    y = JS_DIR_Y * (JS_MID - analogRead(y_pin));
+    // Take the latest samples and convert to x, y.
+    // The ISR won't write this bank until it has filled the other one, which
+    // takes far longer than reading it.
+    uint8_t bank = _jsAdc.bank;
+    x = JS_DIR_X * (JS_MID - (int)_jsAdc.sample[bank][0]);
+    y = JS_DIR_Y * (JS_MID - (int)_jsAdc.sample[bank][1]);
+
+    // Samples for the next poll().  (If loop() is catching up, the last burst
+    // may still be running: it will do.)
+    if (!_jsAdc.busy) adcStart();
     but = digitalRead(but_pin);
 
     // Update debounce timer
-    if (debounce > 0) debounce--;
+    if (debounce && (ticksSince(tick, pressTick) >= JS_DEBOUNCE)) debounce = false;
 
-    if (oldbut && !but && (debounce == 0)) {
+    if (oldbut && !but && !debounce) {
       // Button was up, is now down and debounce not in effect.
       // This is a button press
       pressed = true;
 
       // Start debounce timer
-      debounce = JS_DEBOUNCE;
+      debounce = true;
+      pressTick = tick;
     }
 }
 
@@ -61,96 +237,14 @@ void Joystick::poll()
 // (0 is due "east", 6 is north, 12 west, 18 south.)
 int Joystick::getIndex24()
 {
-    int index = 0;
-    int x = this->x;
-    int y = this->y;
-    bool fold_y = false;
-    bool fold_x = false;
-    bool fold_xy = false;
-    int tmp;
-
-    // fold x, y into 0, 1 positions
-    if (y < 0) {
-	fold_x = true;
-	y = -y;
-    }
-    if (x < 0) {
-	fold_y = true;
-	x = -x;
-    }
-    if (y > x) {
-	fold_xy = true;
-	tmp = x;
-	x = y;
-	y = tmp;
-    }
-
-    float t = (float)y/(float)x;
-    if (t > TAN_22_5) {
-	if (t > TAN_37_5) {
-	    index = 3;
-	}
-	else {
-	    index = 2;
-	}
-    }
-    else {
-	if (t > TAN_7_5) {
-	    index = 1;
-	}
-	else {
-	    index = 0;
-	}
-    }
-
-    // unfold as necessary
-    if (fold_xy) index = 6 - index;
-    if (fold_y) index = 12 - index;
-    if (fold_x) index = 24 - index;
-    if (index == 24) index = 0;
-
-    return index;
+    return sectorIndex<24, true>(x, y, slopes24);
 }
 
 // map joystick x, y into sectors 0-15, in standard orientation
 // (0 is due "east", 4 is north, 8 west, 12 south.)
 int Joystick::getIndex16()
 {
-    int index = 0;
-    int x = this->x;
-    int y = this->y;
-    bool fold_y = false;
-    bool fold_x = false;
-    bool fold_xy = false;
-    int tmp;
-
-    // fold x, y into 0, 1 positions
-    if (y < 0) {
-	fold_x = true;
-	y = -y;
-    }
-    if (x < 0) {
-	fold_y = true;
-	x = -x;
-    }
-    if (y > x) {
-	fold_xy = true;
-	tmp = x;
-	x = y;
-	y = tmp;
-    }
-
-    float t = (float)y/(float)x;
-    if (t > TAN_22_5) {
-	index = 1;
-    }
-
-    // unfold as necessary
-    if (fold_xy) index = 3 - index;
-    if (fold_y) index = 7 - index;
-    if (fold_x) index = 15 - index;
-
-    return index;
+    return sectorIndex<16, false>(x, y, slopes16);
 }
 
 // map joystick x, y into sectors 0-15, in standard orientation
@@ -159,55 +253,10 @@ int Joystick::getIndex16()
 // the cardinal directions.  
 int Joystick::getIndex16_offs()
 {
-    int index = 0;
-    int x = this->x;
-    int y = this->y;
-    bool fold_y = false;
-    bool fold_x = false;
-    bool fold_xy = false;
-    int tmp;
+    // The float version gave 2 for a centered stick (0/0 compared as NaN).  Keep it.
+    if ((x == 0) && (y == 0)) return 2;
 
-    // fold x, y into 0, 1 positions
-    if (y < 0) {
-	fold_x = true;
-	y = -y;
-    }
-    if (x < 0) {
-	fold_y = true;
-	x = -x;
-    }
-    if (y > x) {
-	fold_xy = true;
-	tmp = x;
-	x = y;
-	y = tmp;
-    }
-
-    float t = (float)y/(float)x;
-    if (t < TAN_22_5) {    
-      if (t < TAN_11_25) {
-	index = 0;
-      }
-      else {
-          index = 1;
-      }
-    }
-    else {
-      if (t < TAN_33_75) {
-        index = 1;
-      }
-      else {
-        index = 2;
-      }
-    }
-
-    // unfold as necessary
-    if (fold_xy) index = 4 - index;
-    if (fold_y) index = 8 - index;
-    if (fold_x) index = 16 - index;
-    if (index == 16) index = 0;
-
-    return index;
+    return sectorIndex<16, true>(x, y, slopes16_offs);
 }
 
 bool Joystick::wasPressed()
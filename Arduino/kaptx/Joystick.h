@@ -1,12 +1,14 @@
 #pragma once
 
+#include <stdint.h>
+
 class Joystick
 {
  public:
     Joystick();
 
   void setup();
-  void poll();
+  void poll(uint16_t tick);
 
   int getIndex24();
   int getIndex16();
@@ -26,5 +28,6 @@ class Joystick
   int y;
   bool but;
   bool pressed;
-  unsigned int debounce;
+  bool debounce;            // a press less than JS_DEBOUNCE ago
+  uint16_t pressTick;       // frame of that press
 };
@@ -2,7 +2,9 @@
 #include "Tuning.h"
 #include "Controller.h"
 
-#define PWM_MAX_OFFSET (1600)
+#if (SHOT_QUEUE_LEN & (SHOT_QUEUE_LEN - 1)) || (SHOT_QUEUE_LEN > 256)
+#error SHOT_QUEUE_LEN must be a power of two, 256 at most
+#endif
 
 // ----------------------------------------------------------------------------------
 // Forward declaration
@@ -16,13 +18,23 @@ Model::Model()
     userPos.pan = 6;  // facing away from operator
     userPos.tilt = 0;  // facing horizontal.
 
-    toPwm(&servoPos, &userPos);
+    PanTilt_t pwm;
+    servoPos.pan = 0;
+    toPwm(&pwm, &userPos);
+    servoPos.pan = Q8(pwm.pan);
+    servoPos.tilt = Q8(pwm.tilt);
     servoVel.pan = 0;
     servoVel.tilt = 0;
+    hoVer = false;
+    hoVerPos = Q8(hoVerToPwm(hoVer));
+    hoVerVel = 0;
     shutterPressed = false;
+    shutterHalf = false;
 
     shootMode = MODE_SINGLE;
     shotsQueued = 0;
+    shotsPending = 0;
+    shotHead = 0;
 
     autokap = false;
 
@@ -192,17 +204,19 @@ bool Model::atGoalPos()
     PanTilt_t goal;
     getGoalPwm(&goal);
 
-    return ((goal.pan == servoPos.pan) &&
-	    (goal.tilt == servoPos.tilt) &&
+    return ((Q8(goal.pan) == servoPos.pan) &&
+	    (Q8(goal.tilt) == servoPos.tilt) &&
+	    (Q8(getGoalHoVerPwm()) == hoVerPos) &&
 	    (servoVel.pan == 0) &&
-	    (servoVel.tilt == 0));
+	    (servoVel.tilt == 0) &&
+	    (hoVerVel == 0));
 }
 
 void Model::getGoalPwm(PanTilt_t *goal)
 {
     if (shotsQueued) {
 	// slew target is the head of shot queue
-	*goal = shotQueue[0];
+	*goal = headPwm;
     }
     else {
 	// slew target is user position
@@ -210,12 +224,27 @@ void Model::getGoalPwm(PanTilt_t *goal)
     }
 }
 
-void Model::queueShot(PanTilt_t *aimPoint)
+// HoVer goal, as a PWM value: the head shot's orientation, or the user's.
+int Model::getGoalHoVerPwm()
 {
-    PanTilt_t aimPointPwm;
-    toPwm(&aimPointPwm, aimPoint);
-    
-    queueShotPwm(&aimPointPwm);
+    if (shotsQueued) {
+	return hoVerToPwm(SHOT_VERT(shotQueue[shotHead]));
+    }
+    return hoVerToPwm(hoVer);
+}
+
+void Model::queueShot(PanTilt_t *aimPoint, uint8_t frames, bool vert)
+{
+    // bail out if queue is full
+    if (shotsQueued == SHOT_QUEUE_LEN) return;
+
+    shotQueue[(shotHead + shotsQueued) & SHOT_QUEUE_MASK] =
+	SHOT_SET_VERT(SHOT_SET_FRAMES(SHOT(aimPoint->pan, aimPoint->tilt), frames), vert);
+    shotsQueued++;
+    if (shotsQueued == 1) {
+	setHeadPwm();
+    }
+    dispFlags |= REFRESH_AUTO_COUNT;
 }
 
 unsigned Model::getShotsQueued()
@@ -223,22 +252,58 @@ unsigned Model::getShotsQueued()
     return shotsQueued;
 }
 
-void Model::dequeueShot()
+// Where the head is in the queue: it moves on one for each shot taken.
+uint8_t Model::getShotHead()
+{
+    return shotHead;
+}
+
+Shot_t Model::getShot(unsigned n)
+{
+    return shotQueue[(shotHead + n) & SHOT_QUEUE_MASK];
+}
+
+void Model::setShot(unsigned n, Shot_t shot)
 {
-    for (int n = 0; n < SHOT_QUEUE_LEN-2; n++) {
-	shotQueue[n] = shotQueue[n+1];
+    // The head is the slew target: it must stay put.
+    if ((n == 0) || (n >= shotsQueued)) return;
+
+    shotQueue[(shotHead + n) & SHOT_QUEUE_MASK] = shot;
+}
+
+void Model::setShotsPending(unsigned shots)
+{
+    if (shots != shotsPending) {
+	shotsPending = shots;
+	dispFlags |= REFRESH_AUTO_COUNT;
     }
+}
+
+// Shots left to take: those queued, and those still to be generated.
+unsigned Model::getShotsRemaining()
+{
+    return shotsQueued + shotsPending;
+}
+
+void Model::dequeueShot()
+{
+    if (shotsQueued == 0) return;
+
+    shotHead = (shotHead + 1) & SHOT_QUEUE_MASK;
     shotsQueued--;
+    if (shotsQueued) {
+	setHeadPwm();
+    }
     dispFlags |= REFRESH_AUTO_COUNT;
 }
 
-void Model::getServos(PanTilt_t *pos, PanTilt_t *vel)
+void Model::getServos(PanTiltQ8_t *pos, PanTiltQ8_t *vel)
 {
     *pos = servoPos;
     *vel = servoVel;
 }
 
-void Model::setServos(PanTilt_t *pos, PanTilt_t *vel)
+void Model::setServos(PanTiltQ8_t *pos, PanTiltQ8_t *vel)
 {
     servoPos = *pos;
     servoVel = *vel;
@@ -246,12 +311,29 @@ void Model::setServos(PanTilt_t *pos, PanTilt_t *vel)
 
 int Model::getPanPwm()
 {
-    return servoPos.pan;
+    return Q8_ROUND(servoPos.pan);
 }
 
 int Model::getTiltPwm()
 {
-    return servoPos.tilt;
+    return Q8_ROUND(servoPos.tilt);
+}
+
+void Model::getHoVerServo(long *pos, long *vel)
+{
+    *pos = hoVerPos;
+    *vel = hoVerVel;
+}
+
+void Model::setHoVerServo(long pos, long vel)
+{
+    hoVerPos = pos;
+    hoVerVel = vel;
+}
+
+int Model::getHoVerPwm()
+{
+    return Q8_ROUND(hoVerPos);
 }
 
 bool Model::getShutter()
@@ -264,6 +346,16 @@ void Model::setShutter(bool pressed)
     shutterPressed = pressed;
 }
 
+bool Model::getShutterHalf()
+{
+    return shutterHalf;
+}
+
+void Model::setShutterHalf(bool pressed)
+{
+    shutterHalf = pressed;
+}
+
 void Model::setShutterState(unsigned char state)
 {
     unsigned char lcd_ss;
@@ -294,6 +386,7 @@ void Model::updateLcdShutterState()
     state = SHUTTER_STATE_TRIG;
   }
   else if ((shutterState == SHUTTER_POST) ||
+           (shutterState == SHUTTER_BUSY) ||
            (shutterState == SHUTTER_TRIGGERED)) {
     state = SHUTTER_STATE_ACT;
   }
@@ -310,15 +403,23 @@ void Model::updateLcdShutterState()
   }
 }
 
-void Model::queueShotPwm(PanTilt_t *aimPoint)
+// Convert the new head of the shot queue to PWM values.
+// Use the pan wrap the planner chose for it, if it did.
+void Model::setHeadPwm()
 {
-    // bail out if queue is full
-    if (shotsQueued == SHOT_QUEUE_LEN) return;
+    Shot_t shot = shotQueue[shotHead];
+    PanTilt_t aimPoint;
 
-    PanTilt_t *entry = shotQueue + shotsQueued;
-    *entry = *aimPoint;
-    shotsQueued++;
-    dispFlags |= REFRESH_AUTO_COUNT;
+    aimPoint.pan = SHOT_PAN(shot);
+    aimPoint.tilt = SHOT_TILT(shot);
+    toPwm(&headPwm, &aimPoint);
+
+    if (SHOT_WRAP(shot)) {
+	int pwm = panTurnsToPwm(aimPoint.pan, (int)SHOT_WRAP(shot) - SHOT_WRAP_0);
+	if ((pwm >= -PWM_MAX_OFFSET) && (pwm <= PWM_MAX_OFFSET)) {
+	    headPwm.pan = pwm;
+	}
+    }
 }
 
 static int iabs(int x)
@@ -329,26 +430,24 @@ static int iabs(int x)
     return x;
 }
 
-void Model::toPwm(PanTilt_t *pwm, const PanTilt_t *user)
+int Model::panToPwm(int pan, int near)
 {
-    bool foundMatch;
+    bool foundMatch = false;
     int panPwm = 0;
-    int tiltPwm = 0;
     unsigned currDelta = 0;
     unsigned newDelta = 0;
-    
-    // PAN
-    foundMatch = 0;
+
     for (int cycle = -1; cycle <= 1; cycle++) {
-      int pwm = (user->pan + cycle*ANG_360) * PWM_FACTOR_PAN + PWM_OFFSET_PAN;
+      int pwm = panTurnsToPwm(pan, cycle);
       if ((pwm >= -PWM_MAX_OFFSET) && (pwm <= PWM_MAX_OFFSET)) {
           // This is a valid pwm value.
           if (!foundMatch) {
               // It's the first match found, set current delta (distance needed to move)
+              foundMatch = true;
               panPwm = pwm;
-              currDelta = iabs(pwm - servoPos.pan);
+              currDelta = iabs(pwm - near);
           } else {
-              newDelta = iabs(pwm - servoPos.pan);
+              newDelta = iabs(pwm - near);
               if (newDelta < currDelta) {
                   // the new one is better!
                   panPwm = pwm;
@@ -357,18 +456,34 @@ void Model::toPwm(PanTilt_t *pwm, const PanTilt_t *user)
           }
       }
     }
-    
-    // TILT
-    if (user->tilt < 12) {
-      tiltPwm = user->tilt * PWM_FACTOR_TILT + PWM_OFFSET_TILT;
+
+    return panPwm;
+}
+
+int Model::panTurnsToPwm(int pan, int turns)
+{
+    return (pan + turns*ANG_360) * PWM_FACTOR_PAN + PWM_OFFSET_PAN;
+}
+
+int Model::tiltToPwm(int tilt)
+{
+    if (tilt < 12) {
+      return tilt * PWM_FACTOR_TILT + PWM_OFFSET_TILT;
     }
     else {
       // treat 23, 22, ... as -1, -2, ...
-      tiltPwm = (user->tilt-ANG_360) * PWM_FACTOR_TILT + PWM_OFFSET_TILT;
+      return (tilt-ANG_360) * PWM_FACTOR_TILT + PWM_OFFSET_TILT;
     }
-        
-    // Set servoPos components
-    pwm->pan = panPwm;
-    pwm->tilt = tiltPwm;
 }
 
+int Model::hoVerToPwm(bool vert)
+{
+    return vert ? HOVER_VERT_PWM : HOVER_HOR_PWM;
+}
+
+void Model::toPwm(PanTilt_t *pwm, const PanTilt_t *user)
+{
+    // pan as close as possible to where the servo is now
+    pwm->pan = panToPwm(user->pan, getPanPwm());
+    pwm->tilt = tiltToPwm(user->tilt);
+}
@@ -1,6 +1,15 @@
 #pragma once
 
-#define SHOT_QUEUE_LEN (36)
+#include <stdint.h>
+
+// Shot queue capacity, a power of two.  Entries are 2 bytes each.
+// Shoot sequences are generated as the queue has room, so this is only how far
+// ahead of the shutter they run, not how long a sequence can be: any length runs
+// in these 64 bytes.  (The old queue took 144 bytes and capped a sequence at 36
+// shots.)  It is not 144 entries: more would cost RAM, and would only let the
+// planner look further ahead, for longer planning runs.
+#define SHOT_QUEUE_LEN (32)
+#define SHOT_QUEUE_MASK (SHOT_QUEUE_LEN - 1)
 
 enum Mode_e {
     MODE_SINGLE,
@@ -44,12 +53,46 @@ typedef enum ShutterState_e ShutterState_t;
 #define PAN_MIN (0)
 #define PAN_MAX (23)
 
+#define PWM_MAX_OFFSET (1600)   // servo PWM range, each side of center
+
 struct PanTilt_s {
     int pan;
     int tilt;
 };
 typedef struct PanTilt_s PanTilt_t;
 
+// Servo positions and velocities are Q8 fixed point: PWM units * 256.  They are
+// rounded to whole PWM units only for the PPM output.
+#define Q8_ONE (256L)
+#define Q8(x) ((long)(x) * Q8_ONE)
+#define Q8_ROUND(q) ((int)(((q) + Q8_ONE/2) >> 8))
+
+struct PanTiltQ8_s {
+    long pan;
+    long tilt;
+};
+typedef struct PanTiltQ8_s PanTiltQ8_t;
+
+// Shot queue entry: a user pan and tilt index, packed.
+//   bits 0-4  : pan, 0-23
+//   bits 5-9  : tilt, 0-23
+//   bits 10-11: pan wrap, as planned: 0 for the one nearest the servo when
+//               the shot comes up, else SHOT_WRAP_0 + turns (-1 to 1)
+//   bits 12-14: frames to take there, less one (a burst or bracket)
+//   bit 15    : HoVer orientation, 1 for vertical
+typedef uint16_t Shot_t;
+#define SHOT(pan, tilt) ((Shot_t)(((tilt) << 5) | (pan)))
+#define SHOT_PAN(shot) ((shot) & 0x1f)
+#define SHOT_TILT(shot) (((shot) >> 5) & 0x1f)
+#define SHOT_WRAP(shot) (((shot) >> 10) & 0x03)
+#define SHOT_SET_WRAP(shot, wrap) ((Shot_t)(((shot) & ~(0x03 << 10)) | ((wrap) << 10)))
+#define SHOT_WRAP_0 (2)
+#define SHOT_FRAMES(shot) ((((shot) >> 12) & 0x07) + 1)
+#define SHOT_SET_FRAMES(shot, n) ((Shot_t)(((shot) & ~(0x07 << 12)) | (((n) - 1) << 12)))
+#define SHOT_FRAMES_MAX (8)
+#define SHOT_VERT(shot) (((shot) >> 15) & 0x01)
+#define SHOT_SET_VERT(shot, vert) ((Shot_t)(((shot) & 0x7fff) | ((vert) ? 0x8000 : 0)))
+
 class Model
 {
   public:
@@ -66,20 +109,28 @@ class Model
 
     // current servo positions
     // struct PanTilt servoGoalPos;  // +/- 1000, us deviation from center PWM.
-    PanTilt_t servoPos;      // +/- 1000, us deviation from center PWM
-    PanTilt_t servoVel;      // delta pos per 20ms tick
+    PanTiltQ8_t servoPos;    // +/- 1600, half us deviation from center PWM, Q8
+    PanTiltQ8_t servoVel;    // delta pos per tick, Q8
 
     // int shutterServoPwm;     // PWM value for shutter servo
 
     bool shutterPressed;     // Shutter activated: true
+    bool shutterHalf;        // Shutter half pressed (focusing): true
     bool hoVer;              // HoVer switch: true = vertical;
-    // int hoVerPwm;            // PWM Value for HoVer servo
+    long hoVerPos;           // HoVer servo position, Q8, as servoPos
+    long hoVerVel;           // and velocity
 
     Mode_t shootMode;
     Mode_t shootMode_disp;
 
+    // Shot queue, a ring buffer.  Only the head is converted to PWM values,
+    // when it becomes the head, so its pan wrap is chosen from where the
+    // servos are then.
     unsigned int shotsQueued;
-    PanTilt_t shotQueue[SHOT_QUEUE_LEN];
+    unsigned int shotsPending;        // shots of the sequence not generated yet
+    uint8_t shotHead;                 // index of the oldest entry
+    Shot_t shotQueue[SHOT_QUEUE_LEN];
+    PanTilt_t headPwm;                // head of the queue, as PWM values
 
     bool autokap;
 
@@ -103,6 +154,8 @@ class Model
 
     bool getShutter();
     void setShutter(bool pressed);
+    bool getShutterHalf();
+    void setShutterHalf(bool pressed);
 
     void setAuto(bool state);
     bool getAuto();
@@ -122,20 +175,35 @@ class Model
     // Get goal position, as PWM values
     bool atGoalPos();
     void getGoalPwm(PanTilt_t *goal);
+    int getGoalHoVerPwm();
 
     // Queue shot (using indexed pan/tilt values)
-    void queueShot(PanTilt_t *aimPoint);
+    void queueShot(PanTilt_t *aimPoint, uint8_t frames, bool vert);
     unsigned getShotsQueued();
+    uint8_t getShotHead();                    // queue index of the head
+    Shot_t getShot(unsigned n);               // n: 0 is the head
+    void setShot(unsigned n, Shot_t shot);    // (not the head)
+    void setShotsPending(unsigned shots);
+    unsigned getShotsRemaining();
     void dequeueShot();
     
-    void getServos(PanTilt_t *pos, PanTilt_t *vel);
-    void setServos(PanTilt_t *pos, PanTilt_t *vel);
+    void getServos(PanTiltQ8_t *pos, PanTiltQ8_t *vel);
+    void setServos(PanTiltQ8_t *pos, PanTiltQ8_t *vel);
     int getPanPwm();
     int getTiltPwm();
+    void getHoVerServo(long *pos, long *vel);
+    void setHoVerServo(long pos, long vel);
+    int getHoVerPwm();
+
+    // Index to PWM conversions.  The pan servo may reach a pan index more than
+    // one way: panToPwm() gives the one nearest near, panTurnsToPwm() the one
+    // turns full turns away from pan's own (which may be out of range).
+    static int panToPwm(int pan, int near);
+    static int panTurnsToPwm(int pan, int turns);
+    static int tiltToPwm(int tilt);
+    static int hoVerToPwm(bool vert);
     // int getShutterPwm();
     // void setShutterPwm(int pwm);
-    // int getHoVerPwm();
-    // void setHoVerPwm(int pwm);
 
     void setShutterState(unsigned char state);
 
@@ -145,6 +213,6 @@ class Model
   private:
     // utility methods
     void updateLcdShutterState();
-    void queueShotPwm(PanTilt_t *aimPoint);
+    void setHeadPwm();
     void toPwm(PanTilt_t *pwm, const PanTilt_t *user);
 };
@@ -0,0 +1,69 @@
+#include "Motion.h"
+
+unsigned long isqrt(unsigned long x)
+{
+    unsigned long root = 0;
+    unsigned long bit = 1UL << (sizeof(unsigned long) * 8 - 2);
+
+    while (bit > x) bit >>= 2;
+    while (bit) {
+	if (x >= root + bit) {
+	    x -= root + bit;
+	    root = (root >> 1) + bit;
+	}
+	else {
+	    root >>= 1;
+	}
+	bit >>= 2;
+    }
+    return root;
+}
+
+unsigned long brakeLimit(unsigned long d, unsigned a)
+{
+    if (d == 0) return 0;
+
+    // k*(k+1) >= m, m = 2d/a rounded up
+    unsigned long m = (2 * d + a - 1) / a;
+    unsigned long k = (isqrt(4 * m + 1) - 1) / 2;
+    if (k * (k + 1) < m) k++;
+
+    return k * a;
+}
+
+unsigned moveTicks(unsigned long d, unsigned a, unsigned vmax)
+{
+    // Peak velocity sqrt(a*d) if it never reaches vmax: 2*sqrt(d/a) ticks.
+    // Otherwise vmax/a ticks each to speed up and slow down, and cruise between.
+    // (An axis that doesn't move is common, and the divides are slow on the AVR.)
+    if (d == 0) return 0;
+    if ((unsigned long)vmax * vmax >= (unsigned long)a * d) {
+	return isqrt(4 * d / a);
+    }
+    return d / vmax + vmax / a;
+}
+
+unsigned cruiseFor(unsigned long d, unsigned a, unsigned vmax, unsigned ticks)
+{
+    // d = v*(ticks - v/a): v = (a*ticks - sqrt((a*ticks)^2 - 4*a*d)) / 2
+    // Scaled down as needed so (a*ticks)^2 fits in a long.
+    unsigned long at = (unsigned long)a * ticks;
+    unsigned long ad = (unsigned long)a * d;
+    uint8_t shift = 0;
+    unsigned long v;
+
+    while (at > 0xffff) {
+	at >>= 1;
+	ad >>= 2;
+	shift++;
+    }
+    if (ad >= at * at / 4) {
+	// it can't be stretched that far, only slowed to a triangle
+	return vmax;
+    }
+    v = ((at - isqrt(at * at - 4 * ad) + 1) / 2) << shift;
+
+    if (v > vmax) v = vmax;
+    if (v < 1) v = 1;
+    return v;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Model.h"
+#include "Tuning.h"
+
+// Servo motion model, shared by the SlewController, which moves the servos, and
+// the Planner, which predicts how long moves take.
+//
+// Each axis accelerates at a constant rate a up to a cruise velocity, and brakes
+// at the same rate to stop on target.  Distances are Q8 PWM units, and time is
+// ticks (frames).
+
+// Frames elapsed from start to tick, both frame numbers from Ppm::sync().
+// Correct across counter wrap.
+static inline uint16_t ticksSince(uint16_t tick, uint16_t start)
+{
+    return tick - start;
+}
+
+// Tuning.h gives the rates per 20mS, the standard frame.  A tick is this many
+// of those, so the slew keeps its speed whatever PPM_FRAME_US is.
+#define MOTION_TICK (PPM_FRAME_US / 20000.0)
+
+// Tuning.h rates, per tick, in Q8
+#define ACCEL_PAN_Q8 ((unsigned)(ACCEL_PAN * MOTION_TICK * MOTION_TICK * Q8_ONE))
+#define ACCEL_TILT_Q8 ((unsigned)(ACCEL_TILT * MOTION_TICK * MOTION_TICK * Q8_ONE))
+#define VMAX_PAN_Q8 ((unsigned)(VMAX_PAN * MOTION_TICK * Q8_ONE))
+#define VMAX_TILT_Q8 ((unsigned)(VMAX_TILT * MOTION_TICK * Q8_ONE))
+#define ACCEL_HOVER_Q8 ((unsigned)(ACCEL_HOVER * MOTION_TICK * MOTION_TICK * Q8_ONE))
+#define VMAX_HOVER_Q8 ((unsigned)(VMAX_HOVER * MOTION_TICK * Q8_ONE))
+
+// Ticks each axis' S-curve filter averages the slew over: 1 for none.  A move
+// takes this many ticks, less one, longer.  (2 * ACCEL / JERK is in 20mS units.)
+#ifdef JERK_PAN
+#define SCURVE_PAN ((uint8_t)(2 * ACCEL_PAN / JERK_PAN / MOTION_TICK + 0.999))
+#else
+#define SCURVE_PAN (1)
+#endif
+#ifdef JERK_TILT
+#define SCURVE_TILT ((uint8_t)(2 * ACCEL_TILT / JERK_TILT / MOTION_TICK + 0.999))
+#else
+#define SCURVE_TILT (1)
+#endif
+#ifdef JERK_HOVER
+#define SCURVE_HOVER ((uint8_t)(2 * ACCEL_HOVER / JERK_HOVER / MOTION_TICK + 0.999))
+#else
+#define SCURVE_HOVER (1)
+#endif
+#define SCURVE_BIGGER(a, b) (((a) > (b)) ? (a) : (b))
+#define SCURVE_MAX SCURVE_BIGGER(SCURVE_BIGGER(SCURVE_PAN, SCURVE_TILT), SCURVE_HOVER)
+
+// Integer square root, rounded down.
+unsigned long isqrt(unsigned long x);
+
+// Fastest an axis may be moving, distance d from target, and still stop on it:
+// the least k*a with a*k*(k+1)/2 >= d, as stepping a velocity down by a each
+// tick covers.
+unsigned long brakeLimit(unsigned long d, unsigned a);
+
+// Ticks a move of distance d from rest to rest takes, cruising at vmax at most.
+unsigned moveTicks(unsigned long d, unsigned a, unsigned vmax);
+
+// Cruise velocity that stretches a move of distance d to take ticks, for an
+// axis that would otherwise arrive early.  (At most vmax.)
+unsigned cruiseFor(unsigned long d, unsigned a, unsigned vmax, unsigned ticks);
@@ -0,0 +1,353 @@
+#include "Planner.h"
+
+#include <Arduino.h>
+#include "Tuning.h"
+#include "Motion.h"
+
+// Pan PWM of a full turn: where the servo can reach a pan index twice, the two
+// are this far apart.
+#define PAN_TURN_PWM (ANG_360 * PWM_FACTOR_PAN)
+
+static unsigned uabs(int x)
+{
+    return (x < 0) ? -x : x;
+}
+
+// Pan move between two pan indices, PWM units, by the shorter way the servo
+// can make it.
+static unsigned panDist(int from, int to)
+{
+    int lo = Model::panToPwm(from, -PWM_MAX_OFFSET);
+    int hi = Model::panToPwm(from, PWM_MAX_OFFSET);
+    unsigned d = uabs(Model::panToPwm(to, lo) - lo);
+
+    if (hi != lo) {
+	unsigned d2 = uabs(Model::panToPwm(to, hi) - hi);
+	if (d2 < d) d = d2;
+    }
+    return d;
+}
+
+// Tilt and HoVer moves between two shots, PWM units.
+static unsigned tiltDist(Shot_t from, Shot_t to)
+{
+    return uabs(Model::tiltToPwm(SHOT_TILT(to)) - Model::tiltToPwm(SHOT_TILT(from)));
+}
+
+static unsigned hoVerDist(Shot_t from, Shot_t to)
+{
+    return uabs(Model::hoVerToPwm(SHOT_VERT(to)) - Model::hoVerToPwm(SHOT_VERT(from)));
+}
+
+// Ticks a move of each axis takes under SlewController, which synchronizes them:
+// the slowest axis' time.
+static unsigned slewTicks(unsigned panD, unsigned tiltD, unsigned hoVerD)
+{
+    unsigned pan = moveTicks(Q8(panD), ACCEL_PAN_Q8, VMAX_PAN_Q8) + SCURVE_PAN - 1;
+    unsigned tilt = moveTicks(Q8(tiltD), ACCEL_TILT_Q8, VMAX_TILT_Q8) + SCURVE_TILT - 1;
+    unsigned hover = moveTicks(Q8(hoVerD), ACCEL_HOVER_Q8, VMAX_HOVER_Q8) + SCURVE_HOVER - 1;
+
+    if (tilt > pan) pan = tilt;
+    return (hover > pan) ? hover : pan;
+}
+
+// Stages of a run
+#define PLAN_IDLE (0)
+#define PLAN_NEAREST (1)
+#define PLAN_COSTS (2)
+#define PLAN_TWO_OPT (3)
+#define PLAN_CHOOSE_WRAPS (4)
+
+#define WRAP_NONE (0xffff)
+
+// ----------------------------------------------------------------------------------
+// Public API
+
+Planner::Planner(Model *_model)
+{
+    model = _model;
+    stage = PLAN_IDLE;
+}
+
+void Planner::start()
+{
+    n = model->getShotsQueued();
+    head = model->getShotHead();
+    taken = 0;
+    evals = PLAN_EVALS;
+    i = 1;
+    j = 1;
+    bestTime = 0xffff;
+    stage = (n < 3) ? PLAN_IDLE : PLAN_NEAREST;   // nothing to reorder
+}
+
+void Planner::step()
+{
+    bool more = true;
+
+    if (stage == PLAN_IDLE) return;
+
+    // Shots are only taken from the head, and only queued behind the run's, so
+    // each shot of the run stays where it is in the queue until it is taken.
+    taken = (model->getShotHead() - head) & SHOT_QUEUE_MASK;
+    if ((taken + 3 > n) || (model->getShotsQueued() + taken < n)) {
+	stage = PLAN_IDLE;    // nothing left to reorder
+	return;
+    }
+
+    frameEvals = PLAN_EVALS_FRAME;
+    while (more) {
+	switch (stage) {
+	case PLAN_NEAREST:
+	    more = nearestNeighbour();
+	    break;
+	case PLAN_COSTS:
+	    more = findCosts();
+	    break;
+	case PLAN_TWO_OPT:
+	    more = twoOpt();
+	    break;
+	case PLAN_CHOOSE_WRAPS:
+	    more = chooseWraps();
+	    break;
+	default:
+	    more = false;
+	    break;
+	}
+    }
+}
+
+// --------------------------------------------------------------------------------
+// Utility methods
+//
+// Each stage returns false when this frame's budget is spent, to carry on next
+// frame, and true when it is done and has set up the next one.  Shot k is the
+// run's: shots before the model's head have been taken, and the head stays put.
+
+// From each shot, go to the nearest one left.
+// Nearest is by the slowest axis' move time.  If the budget runs out, the
+// shots not reached yet stay in queue order.
+bool Planner::nearestNeighbour()
+{
+    if (i <= taken) {
+	// the head caught up: go on from it
+	i = taken + 1;
+	j = i;
+	bestTime = 0xffff;
+    }
+
+    while (i < n - 1) {
+	if (j < n) {
+	    if (evals == 0) break;
+	    if (frameEvals == 0) return false;
+
+	    unsigned t = moveTime(getShot(i-1), getShot(j));
+	    if (t < bestTime) {
+		bestTime = t;
+		best = j;
+	    }
+	    j++;
+	}
+	else {
+	    Shot_t tmp = getShot(i);
+	    setShot(i, getShot(best));
+	    setShot(best, tmp);
+	    i++;
+	    j = i;
+	    bestTime = 0xffff;
+	}
+    }
+
+    stage = PLAN_COSTS;
+    i = taken + 1;
+    return true;
+}
+
+// The move into each shot, for 2-opt.  If the budget runs out first, there is
+// no 2-opt.
+bool Planner::findCosts()
+{
+    if (i <= taken) i = taken + 1;
+
+    while (i < n) {
+	if (evals == 0) {
+	    startWraps();
+	    return true;
+	}
+	if (frameEvals == 0) return false;
+
+	cost[i] = moveTime(getShot(i-1), getShot(i));
+	i++;
+    }
+
+    stage = PLAN_TWO_OPT;
+    i = taken + 1;
+    j = i + 1;
+    improved = false;
+    return true;
+}
+
+// Reverse any run of shots that makes the route shorter, until none does or the
+// evaluation budget runs out.  (It leaves chooseWraps() what it needs.)  Move
+// times are symmetric, so a reversed run costs what it did; only the moves into
+// and out of it change.
+bool Planner::twoOpt()
+{
+    for (;;) {
+	if (i <= taken) {
+	    i = taken + 1;
+	    j = i + 1;
+	}
+	if (j >= n) {
+	    i++;
+	    j = i + 1;
+	}
+	if (i >= n - 1) {
+	    // end of a pass: another, if this one found anything
+	    if (!improved) break;
+	    improved = false;
+	    i = taken + 1;
+	    j = i + 1;
+	    continue;
+	}
+	if (evals < 2 + PLAN_WRAPS * PLAN_WRAPS * (n - 1 - taken)) break;
+	if (frameEvals < 2) return false;
+
+	bool last = (j == n - 1);
+	unsigned in = moveTime(getShot(i-1), getShot(j));
+	unsigned out = last ? 0 : moveTime(getShot(i), getShot(j+1));
+	unsigned before = cost[i] + (last ? 0 : cost[j+1]);
+
+	if (in + out < before) {
+	    // reverse shots i..j, and the moves within them
+	    for (unsigned a = i, b = j; a < b; a++, b--) {
+		Shot_t tmp = getShot(a);
+		setShot(a, getShot(b));
+		setShot(b, tmp);
+	    }
+	    for (unsigned a = i + 1, b = j; a < b; a++, b--) {
+		uint16_t tmp = cost[a];
+		cost[a] = cost[b];
+		cost[b] = tmp;
+	    }
+	    cost[i] = in;
+	    if (!last) cost[j+1] = out;
+	    improved = true;
+	}
+	j++;
+    }
+
+    startWraps();
+    return true;
+}
+
+// Choose the pan wrap of each shot, by dynamic programming over the route:
+// for each wrap of each shot, the least time to get there and the wrap of the
+// shot before that it came from.  The head's PWM is already fixed, so the route
+// starts from it (shot j).  (A wrap is the turns from the pan's own PWM value,
+// -1 to 1.)
+void Planner::startWraps()
+{
+    PanTilt_t goal;
+
+    model->getGoalPwm(&goal);
+    for (unsigned w = 0; w < PLAN_WRAPS; w++) {
+	wrapTime[w] = WRAP_NONE;
+    }
+    wrapTime[0] = 0;
+    wrapPwm[0] = goal.pan;
+
+    stage = PLAN_CHOOSE_WRAPS;
+    j = taken;
+    i = taken + 1;
+}
+
+// If the budget runs out, the route is only planned that far, and the shots
+// after it are left to take the nearest wrap when they come up.
+bool Planner::chooseWraps()
+{
+    if (i <= taken) startWraps();    // the head went past where the route started
+
+    while (i < n) {
+	if (evals < PLAN_WRAPS * PLAN_WRAPS) break;
+	if (frameEvals < PLAN_WRAPS * PLAN_WRAPS) return false;
+
+	Shot_t prev = getShot(i-1);
+	Shot_t shot = getShot(i);
+	unsigned tilt = tiltDist(prev, shot);
+	unsigned hover = hoVerDist(prev, shot);
+	unsigned nextTime[PLAN_WRAPS];
+	int nextPwm[PLAN_WRAPS];
+
+	from[i] = 0;
+	for (unsigned w = 0; w < PLAN_WRAPS; w++) {
+	    nextTime[w] = WRAP_NONE;
+	    nextPwm[w] = Model::panTurnsToPwm(SHOT_PAN(shot), (int)w - 1);
+	    if ((nextPwm[w] < -PWM_MAX_OFFSET) || (nextPwm[w] > PWM_MAX_OFFSET)) continue;
+
+	    for (unsigned p = 0; p < PLAN_WRAPS; p++) {
+		if (wrapTime[p] == WRAP_NONE) continue;
+
+		unsigned t = wrapTime[p] + slewTime(uabs(nextPwm[w] - wrapPwm[p]), tilt, hover);
+		if (t < nextTime[w]) {
+		    nextTime[w] = t;
+		    from[i] = (from[i] & ~(0x03 << (2*w))) | (p << (2*w));
+		}
+	    }
+	}
+
+	for (unsigned w = 0; w < PLAN_WRAPS; w++) {
+	    wrapTime[w] = nextTime[w];
+	    wrapPwm[w] = nextPwm[w];
+	}
+	i++;
+    }
+
+    setWraps(i - 1);
+    stage = PLAN_IDLE;
+    return false;
+}
+
+// Best wrap of the last shot planned, then back along the route.
+void Planner::setWraps(unsigned last)
+{
+    unsigned w = 0;
+
+    for (unsigned k = last + 1; k < n; k++) {
+	setShot(k, SHOT_SET_WRAP(getShot(k), 0));
+    }
+
+    for (unsigned v = 1; v < PLAN_WRAPS; v++) {
+	if (wrapTime[v] < wrapTime[w]) w = v;
+    }
+    for (unsigned k = last; k > j; k--) {
+	setShot(k, SHOT_SET_WRAP(getShot(k), SHOT_WRAP_0 + w - 1));
+	w = (from[k] >> (2*w)) & 0x03;
+    }
+}
+
+// Shot k of the run.
+Shot_t Planner::getShot(unsigned k)
+{
+    return model->getShot(k - taken);
+}
+
+void Planner::setShot(unsigned k, Shot_t shot)
+{
+    if (k > taken) model->setShot(k - taken, shot);
+}
+
+// Ticks to slew from one shot to another.
+unsigned Planner::moveTime(Shot_t from, Shot_t to)
+{
+    return slewTime(panDist(SHOT_PAN(from), SHOT_PAN(to)),
+		    tiltDist(from, to), hoVerDist(from, to));
+}
+
+// slewTicks(), charged to the budgets.
+unsigned Planner::slewTime(unsigned panD, unsigned tiltD, unsigned hoVerD)
+{
+    if (evals) evals--;
+    if (frameEvals) frameEvals--;
+    return slewTicks(panD, tiltD, hoVerD);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Model.h"
+
+// Wraps the planner weighs for each shot: -1 to 1 turns.
+#define PLAN_WRAPS (3)
+
+// Reorders the queued shots to cut the time the servos spend slewing between
+// them.  The head of the queue (the current slew target) stays first.
+// Nearest neighbour gives a first route, then 2-opt improves it.  Last, the
+// pan wrap of every shot is chosen together, for the least slew time over the
+// whole route.  All three share PLAN_EVALS move times, and stop where it runs out.
+//
+// A run works through the queue a little each frame (PLAN_EVALS_FRAME move times),
+// on the model's queue itself, while the shots at its head are taken.
+class Planner
+{
+  public:
+    Planner(Model *_model);
+
+  private:
+    // Instance data
+    Model *model;
+    uint8_t stage;            // what the run is doing: PLAN_IDLE when it is not running
+    uint8_t head;             // model's head when the run started: shot 0 of the run
+    uint8_t n;                // shots in the run
+    uint8_t taken;            // of them, taken since it started
+    uint8_t i, j;             // how far the stage has got
+    uint8_t best;             // nearest neighbour: nearest shot to i found yet
+    unsigned bestTime;        // and the ticks to it
+    bool improved;            // 2-opt: this pass reversed a run
+    unsigned evals;           // move times left to work out in this run
+    unsigned frameEvals;      // and in this frame
+    uint16_t cost[SHOT_QUEUE_LEN];  // cost[i]: ticks from shot i-1 to shot i
+    uint8_t from[SHOT_QUEUE_LEN];   // per shot, 2 bits per wrap: the wrap before
+    unsigned wrapTime[PLAN_WRAPS];  // least time to reach each wrap of shot i-1
+    int wrapPwm[PLAN_WRAPS];        // its PWM value
+
+  public:
+    // Public API
+    void start();             // plan the shots queued now, dropping any run under way
+    void step();              // carry on with the run, once a frame
+
+  private:
+    // Utility methods
+    bool nearestNeighbour();
+    bool findCosts();
+    bool twoOpt();
+    void startWraps();
+    bool chooseWraps();
+    void setWraps(unsigned last);
+    Shot_t getShot(unsigned k);
+    void setShot(unsigned k, Shot_t shot);
+    unsigned moveTime(Shot_t from, Shot_t to);
+    unsigned slewTime(unsigned panD, unsigned tiltD, unsigned hoVerD);
+};
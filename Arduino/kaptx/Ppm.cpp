@@ -1,6 +1,7 @@
 #include "Ppm.h"
 
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <Arduino.h>
 
 // Document how this uses Timer 1 and Pin 10.
@@ -17,11 +18,27 @@
 #define CS1_DIV8 (0x02)
 #define TIMSK1_TOIE (0x01)
 
-#define PPM_CHANNELS (6)
 #define PPM_PULSE_WIDTH (800)  // 400uS
 #define PPM_CENTER (3000)      // 1.5mS
 #define PPM_RANGE (1600)       // 800uS throw, each side of center.
-#define PPM_FRAME_LEN (40000)  // 20ms -> 50Hz
+#define PPM_FRAME_LEN (PPM_FRAME_US*2L)    // 40000 -> 20ms -> 50Hz
+#define PPM_SYNC_MIN (PPM_SYNC_MIN_US*2)
+
+// Check the PPM configuration from Tuning.h
+#if (PPM_CHANNELS < 4) || (PPM_CHANNELS > 8)
+#error PPM_CHANNELS must be from 4 to 8
+#endif
+#if (PPM_FRAME_US < 10000) || (PPM_FRAME_US > 20000)
+#error PPM_FRAME_US must be from 10000 (100Hz) to 20000 (50Hz)
+#endif
+#if (PPM_SYNC_MIN_US < PPM_PULSE_WIDTH/2)
+#error PPM_SYNC_MIN_US must be longer than one PPM pulse
+#endif
+// Every channel at full throw must still leave the sync gap, so the frame never
+// has to stretch and the frame tick stays even.
+#if (PPM_CHANNELS * (PPM_CENTER + PPM_RANGE) + PPM_SYNC_MIN) > PPM_FRAME_LEN
+#error PPM_FRAME_US is too short to hold PPM_CHANNELS channels at full throw and PPM_SYNC_MIN_US
+#endif
 
 // Uncomment one of these according to your Arduino's speed
 // #define MHZ_8
@@ -35,36 +52,121 @@
 
 #ifdef MHZ_16
 #define T1_CLOCKS(n) (n)
+#define T1_US(n) ((n) >> 1)
 #endif
 #ifdef MHZ_8
 #define T1_CLOCKS(n) (n >> 1)
+#define T1_US(n) (n)
 #endif
 
 // ---------------------------------------------------------------------------------
 
+#define PPM_PHASES (PPM_CHANNELS+1)  // one phase per channel, then the resync phase
+
+// Uncomment to have the ISR check its own latency against PPM_ISR_BUDGET.
+// #define PPM_ISR_CHECK
+
+// Worst case CPU cycles from timer overflow to the end of the ISR,
+// including time spent waiting behind other interrupts.
+// Timer1 runs at clock/8, so the check has a resolution of 8 cycles.
+#define PPM_ISR_BUDGET (160)
+
+// Slack histogram: how much of each frame was left when loop() called sync().
+// Bins are PPM_FRAME_US/PPM_SLACK_BINS wide, bin 0 being the least slack.
+#define PPM_SLACK_BINS (8)
+
+// ---------------------------------------------------------------------------------
+
 struct Ppm_s {
-    unsigned phase; // which phase of PPM we are in, 0-6.  6 is long resync phase. 
-    uint16_t time[PPM_CHANNELS];  // width of each PPM channel (1 = 0.5uS)
-    volatile bool startCycle;
+    const uint16_t *next;   // next entry of the active schedule to load into OCR1A
+    const uint16_t *end;    // end of the active schedule
+    uint16_t staged[PPM_CHANNELS];    // channel widths written by write(), not seen by ISR
+
+    // Double buffered OCR1A schedule: each channel width, then the resync gap. (1 = 0.5uS)
+    // Entries are TOP values, one less than the phase length.
+    uint16_t sched[2][PPM_PHASES];
+    volatile uint8_t active;          // sched[] buffer the ISR is sending
+    volatile bool pending;            // sched[active^1] holds a committed frame
+    volatile uint16_t frames;         // frame counter, the controllers' timebase
+    uint16_t syncFrame;               // value of frames when sync() last returned
+
+#ifdef PPM_ISR_CHECK
+    volatile uint16_t isrTicks;       // worst ISR latency seen, Timer1 ticks
+    volatile uint16_t isrOverruns;    // times PPM_ISR_BUDGET was exceeded
+#endif
+
+#ifdef LOOP_PROFILE
+    // Free running Timer1 clock for clock(): Timer1 tick the running phase
+    // started, and the lengths of the running and next phases.
+    volatile uint16_t clockBase;
+    volatile uint16_t runLen;
+    uint16_t nextLen;
+#endif
 } _ppm;
 
+struct PpmSlack_s {
+    unsigned long frameStart;  // micros() when sync() last returned
+    bool skip;                 // don't measure the next frame
+    uint16_t usedMin;          // least time loop() used, uS
+    uint16_t usedMax;          // most time loop() used, uS
+    uint16_t overruns;         // frames loop() used completely
+    uint16_t hist[PPM_SLACK_BINS];
+} _slack;
+
 ISR(TIMER1_OVF_vect) 
 {
-    static uint16_t remainder = T1_CLOCKS(PPM_FRAME_LEN);
-
     // Handle Timer 1 overflow: Start of PPM interval
-    // Program total length of this phase in 0.5uS units.
-    if (_ppm.phase >= PPM_CHANNELS) {
-        OCR1A = remainder;
-	remainder = T1_CLOCKS(PPM_FRAME_LEN);
- 	_ppm.phase = 0;
-	_ppm.startCycle = true;
-   }
-    else {
-        OCR1A = _ppm.time[_ppm.phase];
-        remainder -= _ppm.time[_ppm.phase];
-        _ppm.phase++;
+    // Program total length of the next phase.  commit() already did the arithmetic.
+    OCR1A = *_ppm.next;
+
+#ifdef LOOP_PROFILE
+    // OCR1A is double buffered, so the value just written times the phase after
+    // the one now starting.  A phase of TOP lasts TOP+1 ticks.
+    _ppm.clockBase += _ppm.runLen;
+    _ppm.runLen = _ppm.nextLen;
+    _ppm.nextLen = *_ppm.next + 1;
+#endif
+
+    _ppm.next++;
+
+    if (_ppm.next == _ppm.end) {
+	// Resync phase was just programmed: this is the frame boundary,
+	// the only place a committed frame is swapped in.
+	if (_ppm.pending) {
+	    _ppm.active ^= 1;
+	    _ppm.pending = false;
+	}
+	_ppm.next = _ppm.sched[_ppm.active];
+	_ppm.end = _ppm.next + PPM_PHASES;
+	_ppm.frames++;
+    }
+
+#ifdef PPM_ISR_CHECK
+    // TCNT1 restarted from zero at the overflow, so it is our latency.
+    uint16_t ticks = TCNT1;
+    if (ticks > _ppm.isrTicks) {
+	_ppm.isrTicks = ticks;
+    }
+    if (ticks > PPM_ISR_BUDGET/8) {
+	_ppm.isrOverruns++;
+    }
+#endif
+}
+
+// Fill a schedule from the staged channel widths, with the resync gap last.
+// The gap makes up the frame length; the checks above make sure it is never
+// shorter than PPM_SYNC_MIN.
+// A phase lasts TOP+1 ticks, so each entry is its width less one.
+static void buildSchedule(uint16_t *sched)
+{
+    uint16_t used = 0;
+
+    for (unsigned n = 0; n < PPM_CHANNELS; n++) {
+	sched[n] = _ppm.staged[n] - 1;
+	used += _ppm.staged[n];
     }
+
+    sched[PPM_CHANNELS] = T1_CLOCKS(PPM_FRAME_LEN) - used - 1;
 }
 
 // ---------------------------------------------------------------------------------------------
@@ -82,25 +184,38 @@ void Ppm::setup()
 
     // Init PPM phases
     for (unsigned n = 0; n < PPM_CHANNELS; n++) {
-	_ppm.time[n] = T1_CLOCKS(PPM_CENTER);  // 1.5mS
+	_ppm.staged[n] = T1_CLOCKS(PPM_CENTER);  // 1.5mS
     }
+    buildSchedule(_ppm.sched[0]);
+    _ppm.active = 0;
+    _ppm.pending = false;
     
     // Start PPM Generation on idle phase
-    _ppm.phase = PPM_CHANNELS-1;
-    _ppm.startCycle = true;
+    _ppm.next = _ppm.sched[0] + PPM_CHANNELS;
+    _ppm.end = _ppm.next + 1;
+    _ppm.frames = 0;
+    _ppm.syncFrame = 0;
+
+#ifdef LOOP_PROFILE
+    _ppm.clockBase = 0;
+    _ppm.runLen = T1_CLOCKS(PPM_FRAME_LEN);
+    _ppm.nextLen = T1_CLOCKS(PPM_FRAME_LEN);
+#endif
+
+    clearSlack();
 
     // Init for PPM Generation
 
     TCCR1A = WGM_15_1A | COM1A_00 | COM1B_11 | COM1C_00; // Fast PWM with OCR1A defining TOP
     TCCR1B = WGM_15_1B | CS1_DIV8;                       // Prescaler : system clock / 8.
     TCCR1C = 0;                                          // Not used
-    OCR1A = T1_CLOCKS(PPM_FRAME_LEN);                               // First frame len
+    OCR1A = T1_CLOCKS(PPM_FRAME_LEN) - 1;                           // First frame len
     OCR1B = T1_CLOCKS(PPM_PULSE_WIDTH);                             // Width of pulses
     // OCR1C = 0;                                           // Not used
     TIMSK1 = TIMSK1_TOIE;                                // interrupt on overflow (end of phase)
 }
 
-// Set PPM Channel to value.
+// Stage PPM Channel value.  It is not sent until commit() is called.
 // A value of zero corresponds to the center of throw, pulse width of 1500uS
 // A positive value, v, corresponds to a longer pulse
 void Ppm::write(int chan, int value)
@@ -111,16 +226,169 @@ void Ppm::write(int chan, int value)
   // silently fail if value is out of range
   if ((value < -PPM_RANGE) || (value > PPM_RANGE)) return;
 
-  // Store this channel's time
-  _ppm.time[chan-1] = T1_CLOCKS(PPM_CENTER + value);
+  // Stage this channel's time
+  _ppm.staged[chan-1] = T1_CLOCKS(PPM_CENTER + value);
+}
+
+// Hand all staged channels to the ISR as one frame.
+// The ISR swaps it in at the next resync phase, never mid-frame.
+void Ppm::commit()
+{
+  // With pending clear the ISR will not swap, so the back buffer is ours.
+  // (A committed frame the ISR has not picked up yet is simply replaced.)
+  _ppm.pending = false;
+
+  buildSchedule(_ppm.sched[_ppm.active ^ 1]);
+
+  _ppm.pending = true;
 }
 
-// Wait until next PPM cycle starts
-void Ppm::sync()
+// Worst case ISR latency seen so far, in CPU cycles.  (0 without PPM_ISR_CHECK)
+unsigned Ppm::getIsrCycles()
 {
-  // clear start cycle flag
-  _ppm.startCycle = false;
+  unsigned ticks = 0;
+
+#ifdef PPM_ISR_CHECK
+  uint8_t sreg = SREG;
+  cli();
+  ticks = _ppm.isrTicks;
+  SREG = sreg;
+#endif
+
+  return ticks * 8;
+}
+
+// Number of times the ISR ran past PPM_ISR_BUDGET.  (0 without PPM_ISR_CHECK)
+unsigned Ppm::getIsrOverruns()
+{
+  unsigned overruns = 0;
+
+#ifdef PPM_ISR_CHECK
+  uint8_t sreg = SREG;
+  cli();
+  overruns = _ppm.isrOverruns;
+  SREG = sreg;
+#endif
+
+  return overruns;
+}
+
+// Wait until next PPM cycle starts, and return its frame number.
+// If loop() overran, frames have already started since the last call: return at
+// once so the caller can catch up.  Otherwise the MCU idles in sleep until
+// the Timer1 ISR starts the next frame.
+uint16_t Ppm::sync()
+{
+  uint16_t frame;
+
+  // account for the time loop() used since the frame started
+  measureSlack();
+
+  // sleep until the ISR counts a new frame.
+  // Interrupts are off while testing the counter, and sei() takes effect only after
+  // the following instruction, so the ISR can't slip in between test and sleep.
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  cli();
+  while (_ppm.frames == _ppm.syncFrame) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      cli();
+  }
+  frame = _ppm.frames;
+  sei();
+
+  _ppm.syncFrame = frame;
+  _slack.frameStart = micros();
+
+  return frame;
+}
+
+#ifdef LOOP_PROFILE
+// Free running clock in Timer1 ticks, for timing code within a frame or two.
+// (It wraps every 32mS at 16MHz.)  Use clockUs() to convert a difference.
+uint16_t Ppm::clock()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t base = _ppm.clockBase;
+  uint16_t t = TCNT1;
+  if (TIFR1 & _BV(TOV1)) {
+      // Timer1 wrapped but the ISR hasn't run yet: the running phase has ended.
+      t = TCNT1;
+      base += _ppm.runLen;
+  }
+  SREG = sreg;
+
+  return base + t;
+}
+
+unsigned Ppm::clockUs(uint16_t ticks)
+{
+  return T1_US(ticks);
+}
+#endif
+
+// Print frame slack statistics to Serial, then start over.
+// Printing takes longer than a frame, so the frame it happens in isn't counted.
+void Ppm::printSlack()
+{
+  Serial.print(F("used uS min "));
+  Serial.print(_slack.usedMin);
+  Serial.print(F(" max "));
+  Serial.print(_slack.usedMax);
+  Serial.print(F(" over "));
+  Serial.println(_slack.overruns);
+
+  Serial.print(F("slack hist"));
+  for (unsigned n = 0; n < PPM_SLACK_BINS; n++) {
+      Serial.print(' ');
+      Serial.print(_slack.hist[n]);
+  }
+  Serial.println();
+
+  Serial.print(F("isr cycles "));
+  Serial.print(getIsrCycles());
+  Serial.print(F(" over "));
+  Serial.println(getIsrOverruns());
+
+  clearSlack();
+}
+
+// --------------------------------------------------------------------------------
+// Utility methods
+
+void Ppm::clearSlack()
+{
+  _slack.usedMin = 0xffff;
+  _slack.usedMax = 0;
+  _slack.overruns = 0;
+  for (unsigned n = 0; n < PPM_SLACK_BINS; n++) {
+      _slack.hist[n] = 0;
+  }
+  _slack.skip = true;
+}
+
+void Ppm::measureSlack()
+{
+  unsigned long used = micros() - _slack.frameStart;
+
+  if (_slack.skip) {
+      _slack.skip = false;
+      return;
+  }
+
+  if (used > 0xffff) used = 0xffff;
+  if (used < _slack.usedMin) _slack.usedMin = used;
+  if (used > _slack.usedMax) _slack.usedMax = used;
+
+  if (used >= PPM_FRAME_US) {
+      // loop() used the whole frame (at least), a frame was skipped.
+      _slack.overruns++;
+      used = PPM_FRAME_US - 1;
+  }
 
-  // wait for start cycle flag to be set again by ISR
-  while (!_ppm.startCycle);
+  unsigned bin = (PPM_FRAME_US - 1 - used) * PPM_SLACK_BINS / PPM_FRAME_US;
+  if (_slack.hist[bin] < 0xffff) _slack.hist[bin]++;
 }
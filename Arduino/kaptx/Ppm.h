@@ -1,6 +1,8 @@
 #pragma once
 
-#define PPM_CHANNELS (6)
+#include <stdint.h>
+
+#include "Tuning.h"  // PPM_CHANNELS, PPM_FRAME_US
 
 // TODO: Convert API value param from 0.5uS ticks to 1uS ticks
 
@@ -12,12 +14,31 @@ class Ppm
   
   void setup();
 
-  // Set PPM Channel to value.
+  // Stage PPM Channel value for the next frame.
   // A value of zero corresponds to the center of throw, pulse width of 1500uS
   // A positive value, v, corresponds to a longer pulse
   // value is in half-microsecond increments from -1600 to 1600.
   void write(int chan, int value);
 
-  // Wait until next PPM cycle starts
-  void sync();
+  // Send all staged channels together, starting with the next PPM frame.
+  void commit();
+
+  // Wait until next PPM cycle starts, sleeping meanwhile.
+  // Returns the frame number, which counts up once per PPM frame (and wraps).
+  uint16_t sync();
+
+  // Print how much of each frame loop() has used, since the last print.
+  void printSlack();
+
+  // Timer1 based clock for profiling (needs LOOP_PROFILE in Tuning.h)
+  uint16_t clock();
+  unsigned clockUs(uint16_t ticks);
+
+  // ISR latency budget check (enable PPM_ISR_CHECK in Ppm.cpp)
+  unsigned getIsrCycles();
+  unsigned getIsrOverruns();
+
+  private:
+  void clearSlack();
+  void measureSlack();
 };
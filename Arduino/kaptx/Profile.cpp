@@ -0,0 +1,89 @@
+#include "Profile.h"
+
+#include <Arduino.h>
+#include "Ppm.h"
+#include "Tuning.h"
+
+#ifdef LOOP_PROFILE
+
+Profile::Profile(Ppm *_ppm) :
+    ppm(_ppm)
+{
+    last = 0;
+    ringHead = 0;
+    ringCount = 0;
+    clearWindow();
+}
+
+void Profile::mark(unsigned char stage)
+{
+    uint16_t now = ppm->clock();
+    unsigned us = ppm->clockUs(now - last);
+    last = now;
+
+    if (us < min[stage]) min[stage] = us;
+    if (us > max[stage]) max[stage] = us;
+    sum[stage] += us;
+
+    if (stage == NUM_PROF_STAGES-1) {
+	// end of loop()
+	frames++;
+	if (frames == PROF_WINDOW) {
+	    closeWindow();
+	}
+    }
+}
+
+void Profile::print()
+{
+    Serial.println(F("prof uS min/avg/max, newest first"));
+    Serial.println(F("sync poll ctrl pan tilt shut hover ch6 commit view"));
+
+    for (unsigned n = 0; n < ringCount; n++) {
+	unsigned w = (ringHead + PROF_RING - 1 - n) % PROF_RING;
+
+	for (unsigned stage = 0; stage < NUM_PROF_STAGES; stage++) {
+	    ProfStat_t *stat = &ring[w][stage];
+	    Serial.print(stat->min);
+	    Serial.print('/');
+	    Serial.print(stat->avg);
+	    Serial.print('/');
+	    Serial.print(stat->max);
+	    Serial.print(' ');
+	}
+	Serial.println();
+    }
+
+    // Don't charge the time spent printing to the next stage.
+    last = ppm->clock();
+}
+
+// --------------------------------------------------------------------------------
+// Utility methods
+
+void Profile::clearWindow()
+{
+    frames = 0;
+    for (unsigned stage = 0; stage < NUM_PROF_STAGES; stage++) {
+	min[stage] = 0xffff;
+	max[stage] = 0;
+	sum[stage] = 0;
+    }
+}
+
+void Profile::closeWindow()
+{
+    for (unsigned stage = 0; stage < NUM_PROF_STAGES; stage++) {
+	ProfStat_t *stat = &ring[ringHead][stage];
+	stat->min = min[stage];
+	stat->avg = sum[stage] / PROF_WINDOW;
+	stat->max = max[stage];
+    }
+
+    ringHead = (ringHead + 1) % PROF_RING;
+    if (ringCount < PROF_RING) ringCount++;
+
+    clearWindow();
+}
+
+#endif
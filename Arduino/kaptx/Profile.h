@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+class Ppm;
+
+// Stages of loop() that are timed, in the order they run.
+enum ProfStage_e {
+    PROF_SYNC,           // includes sleeping until the frame starts
+    PROF_POLL,
+    PROF_CONTROL,
+    PROF_WRITE_PAN,
+    PROF_WRITE_TILT,
+    PROF_WRITE_SHUTTER,
+    PROF_WRITE_HOVER,
+    PROF_WRITE_6,
+    PROF_COMMIT,
+    PROF_VIEW,
+
+    // keep this last
+    NUM_PROF_STAGES,
+};
+
+#define PROF_WINDOW (50)  // frames summarized in each ring entry
+#define PROF_RING (4)     // number of summaries kept
+
+// Summary of one stage over one window.  [uS]
+struct ProfStat_s {
+    uint16_t min;
+    uint16_t avg;
+    uint16_t max;
+};
+typedef struct ProfStat_s ProfStat_t;
+
+class Profile
+{
+  public:
+    Profile(Ppm *_ppm);
+
+  private:
+    // Instance data
+    Ppm *ppm;
+    uint16_t last;        // clock when the previous stage ended
+
+    // window being measured
+    unsigned char frames;
+    uint16_t min[NUM_PROF_STAGES];
+    uint16_t max[NUM_PROF_STAGES];
+    unsigned long sum[NUM_PROF_STAGES];
+
+    // finished windows, oldest overwritten first
+    ProfStat_t ring[PROF_RING][NUM_PROF_STAGES];
+    unsigned char ringHead;
+    unsigned char ringCount;
+
+  public:
+    // Public API
+    // Mark the end of a stage.  Its time runs from the end of the previous stage.
+    void mark(unsigned char stage);
+
+    // Print the ring, newest window first, to Serial.
+    void print();
+
+  private:
+    // Utility methods
+    void clearWindow();
+    void closeWindow();
+};
@@ -0,0 +1,285 @@
+#include "Sequence.h"
+
+#include <Arduino.h>
+#include "Tuning.h"
+
+// ----------------------------------------------------------------------------------
+// Patterns, one per shoot mode.  P_IF_TILT targets are pattern byte offsets.
+
+static const uint8_t patSingle[] PROGMEM = {
+    P_SHOTS, 1, OFF(0, 0),
+    P_END,
+};
+
+static const uint8_t patCluster[] PROGMEM = {
+    // get tilt off the rails so cluster doesn't collapse on itself.
+    /*  0 */ P_OFF_RAIL,
+    // Choose sequence
+    /*  1 */ P_IF_TILT, 0, 2, 28,      // high
+    /*  5 */ P_IF_TILT, 22, 23, 28,    // high
+    /*  9 */ P_IF_TILT, 19, 21, 18,    // med
+    /* 13 */ P_IF_TILT, 18, 18, 38,    // low
+    // use medium cluster pattern, with pan+180, tilt on other side of zenith
+    /* 17 */ P_MIRROR,
+    /* 18 */ P_SHOTS, 7,               // med
+    OFF(0, 0), OFF(1, 1), OFF(2, 0), OFF(2, -1), OFF(-2, -1), OFF(-2, 0), OFF(-1, 1),
+    /* 27 */ P_END,
+    /* 28 */ P_SHOTS, 7,               // high
+    OFF(0, 0), OFF(1, 1), OFF(2, 0), OFF(1, -1), OFF(-1, -1), OFF(-2, 0), OFF(-1, 1),
+    /* 37 */ P_END,
+    /* 38 */ P_SHOTS, 7,               // low
+    OFF(0, 0), OFF(0, 2), OFF(0, -2), OFF(4, -2), OFF(4, 2), OFF(-4, 2), OFF(-4, -2),
+    /* 47 */ P_END,
+};
+
+static const uint8_t patVpan[] PROGMEM = {
+    // user's aim point for first shot.
+    P_SHOTS, 1, OFF(0, 0),
+    // Shots spanning 90 degrees of tilt, down from a top found by going 45 degrees
+    // down from the user's tilt, then 90 up (constrained by range of motion).
+    P_TILT_CLAMP, STEP(-3),
+    P_TILT_CLAMP, STEP(6),
+    P_SHOTS, 7, OFF(0, 0), OFF(0, -1), OFF(0, -2), OFF(0, -3), OFF(0, -4), OFF(0, -5), OFF(0, -6),
+    P_END,
+};
+
+static const uint8_t patHpan[] PROGMEM = {
+    // user's aim point for first shot.
+    /*  0 */ P_SHOTS, 1, OFF(0, 0),
+    // Shots 45 degrees left to 45 right, two rows, the second row toward
+    // the horizon.
+    /*  3 */ P_IF_TILT, 3, 18, 18,
+    /*  7 */ P_SHOTS, 8,
+    OFF(-3, 0), OFF(-3, -2), OFF(-1, 0), OFF(-1, -2), OFF(1, 0), OFF(1, -2), OFF(3, 0), OFF(3, -2),
+    /* 17 */ P_END,
+    /* 18 */ P_SHOTS, 8,
+    OFF(-3, 0), OFF(-3, 2), OFF(-1, 0), OFF(-1, 2), OFF(1, 0), OFF(1, 2), OFF(3, 0), OFF(3, 2),
+    /* 28 */ P_END,
+};
+
+static const uint8_t patQuad[] PROGMEM = {
+    P_TILT, 0,
+    P_SHOTS, 13,
+    OFF(-3, 0), OFF(-3, -2), OFF(-3, -4), OFF(-3, -6),
+    OFF(-1, 0), OFF(-1, -2),
+    OFF(0, -4),
+    OFF(1, -2), OFF(1, 0),
+    OFF(3, 0), OFF(3, -2), OFF(3, -4), OFF(3, -6),
+    P_END,
+};
+
+static const uint8_t pat360[] PROGMEM = {
+    P_TILT, 0,
+    P_REPEAT, 4,   // shoot 4 quadrants
+    P_SHOTS, 9,
+    OFF(0, 0), OFF(0, -2), OFF(0, -4), OFF(0, -6),
+    OFF(2, 0), OFF(2, -2),
+    OFF(3, -4),
+    OFF(4, -2), OFF(4, 0),
+    P_LOOP, STEP(6),
+    P_END,
+};
+
+// Indexed by Mode_t
+static const uint8_t * const patterns[] PROGMEM = {
+    patSingle,
+    patCluster,
+    patVpan,
+    patHpan,
+    patQuad,
+    pat360,
+};
+
+static_assert(sizeof(patterns)/sizeof(patterns[0]) == NUM_MODES, "need a pattern for each mode");
+
+// Frames at each shot, indexed by Mode_t
+static const uint8_t bursts[] PROGMEM = {
+    BURST_SINGLE,
+    BURST_CLUSTER,
+    BURST_VPAN,
+    BURST_HPAN,
+    BURST_QUAD,
+    BURST_360,
+};
+
+static_assert(sizeof(bursts) == NUM_MODES, "need a burst count for each mode");
+
+#define BURST_OK(n) (((n) >= 1) && ((n) <= SHOT_FRAMES_MAX))
+static_assert(BURST_OK(BURST_SINGLE) && BURST_OK(BURST_CLUSTER) && BURST_OK(BURST_VPAN) &&
+	      BURST_OK(BURST_HPAN) && BURST_OK(BURST_QUAD) && BURST_OK(BURST_360),
+	      "BURST_ counts must be from 1 to 8");
+
+// ----------------------------------------------------------------------------------
+// Public API
+
+ShotSequence::ShotSequence()
+{
+    count = 0;
+    n = 0;
+    burst = 1;
+}
+
+// Start a new sequence for a shoot mode, around the user's aim point.
+void ShotSequence::start(Mode_t mode, const PanTilt_t *userPos, bool _userVert)
+{
+    start((const uint8_t *)pgm_read_ptr(&patterns[mode]), pgm_read_byte(&bursts[mode]),
+	  userPos, _userVert);
+}
+
+// Start a sequence running a pattern (in PROGMEM), frames at each shot.
+void ShotSequence::start(const uint8_t *_pattern, uint8_t frames, const PanTilt_t *userPos,
+			 bool _userVert)
+{
+    PanTilt_t aimPoint;
+
+    pattern = _pattern;
+    burst = frames;
+    pc = 0;
+    shots = 0;
+    loops = 0;
+    base = *userPos;
+    userVert = _userVert;
+    vert = userVert;
+
+    // Count the shots with a dry run, for the display.
+    ShotSequence dryRun = *this;
+    count = 0;
+    while (dryRun.step(&aimPoint)) {
+	count++;
+    }
+    n = 0;
+}
+
+// Shots not yet generated.
+unsigned ShotSequence::remaining()
+{
+    return count - n;
+}
+
+// Generate the next shot, and its HoVer orientation.  Returns false when the
+// sequence is done.
+bool ShotSequence::next(PanTilt_t *aimPoint, bool *_vert)
+{
+    if (n >= count) return false;
+
+    step(aimPoint);
+    *_vert = vert;
+    n++;
+    return true;
+}
+
+// Frames to take at each shot of the sequence.
+uint8_t ShotSequence::frames()
+{
+    return burst;
+}
+
+// --------------------------------------------------------------------------------
+// Utility methods
+
+// Run the pattern up to its next shot.  Returns false at P_END.
+bool ShotSequence::step(PanTilt_t *aimPoint)
+{
+    for (;;) {
+	if (shots) {
+	    uint8_t off = fetch();
+	    shots--;
+	    aimPoint->pan = addPan(base.pan, OFF_PAN(off));
+	    aimPoint->tilt = addTilt(base.tilt, OFF_TILT(off));
+	    return true;
+	}
+
+	switch (fetch()) {
+	    case P_SHOTS:
+		shots = fetch();
+		break;
+	    case P_TILT:
+		base.tilt = fetch();
+		break;
+	    case P_TILT_CLAMP:
+		base.tilt = clampTilt(base.tilt, (int8_t)fetch());
+		break;
+	    case P_OFF_RAIL:
+		if (base.tilt == TILT_MAX) base.tilt -= 1;
+		if (base.tilt == TILT_MIN) base.tilt += 1;
+		break;
+	    case P_MIRROR:
+		base.pan = addPan(base.pan, ANG_360/2);
+		base.tilt = 18 + (18 - base.tilt);
+		break;
+	    case P_IF_TILT: {
+		uint8_t lo = fetch();
+		uint8_t hi = fetch();
+		uint8_t target = fetch();
+		if ((base.tilt >= lo) && (base.tilt <= hi)) pc = target;
+		break;
+	    }
+	    case P_REPEAT:
+		loops = fetch();
+		loopPc = pc;
+		break;
+	    case P_LOOP:
+		base.pan = addPan(base.pan, (int8_t)fetch());
+		if (loops && --loops) pc = loopPc;
+		break;
+	    case P_HOVER:
+		switch (fetch()) {
+		    case HV_HOR: vert = false; break;
+		    case HV_VERT: vert = true; break;
+		    case HV_OTHER: vert = !userVert; break;
+		    default: vert = userVert; break;
+		}
+		break;
+	    default:
+		// P_END, or a bad pattern
+		pc--;
+		return false;
+	}
+    }
+}
+
+uint8_t ShotSequence::fetch()
+{
+    return pgm_read_byte(pattern + pc++);
+}
+
+int ShotSequence::addPan(int pan, int step)
+{
+  pan += step;
+  if (pan < 0) pan += ANG_360;
+  if (pan >= ANG_360) pan -= ANG_360;
+  
+  return pan;
+}
+
+int ShotSequence::addTilt(int tilt, int step)
+{
+  tilt += step;
+  if (tilt >= ANG_360) tilt -= ANG_360;
+  if (tilt < 0) tilt += ANG_360;
+  
+  if ((tilt > TILT_MAX) && (tilt < TILT_MID_DEAD)) tilt = TILT_MAX;
+  if ((tilt < TILT_MIN) && (tilt >= TILT_MID_DEAD)) tilt = TILT_MIN;
+  
+  return tilt;
+}
+
+// Move tilt along its range of motion, TILT_MIN to TILT_MAX through level,
+// stopping at either end.
+int ShotSequence::clampTilt(int tilt, int step)
+{
+    const int range = TILT_MAX - TILT_MIN + ANG_360;   // TILT_MIN to TILT_MAX, in steps
+
+    // position along the range, 0 at TILT_MIN
+    int pos = tilt - TILT_MIN;
+    if (pos < 0) pos += ANG_360;
+
+    pos += step;
+    if (pos < 0) pos = 0;
+    if (pos > range) pos = range;
+
+    tilt = TILT_MIN + pos;
+    if (tilt >= ANG_360) tilt -= ANG_360;
+
+    return tilt;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Model.h"
+
+// Pattern ops.  A pattern is a list of these, each followed by its operands.
+
+#define P_END (0)         // sequence done
+#define P_SHOTS (1)       // n, then n OFF() bytes: a shot at base + each offset
+#define P_TILT (2)        // tilt: set base tilt
+#define P_TILT_CLAMP (3)  // step: move base tilt, stopping at TILT_MIN/TILT_MAX
+#define P_OFF_RAIL (4)    // move base tilt one step in from TILT_MIN/TILT_MAX
+#define P_MIRROR (5)      // base to the other side of nadir: pan + 180, tilt mirrored
+#define P_IF_TILT (6)     // lo, hi, target: go to target if lo <= base tilt <= hi
+#define P_REPEAT (7)      // n: run up to P_LOOP n times
+#define P_LOOP (8)        // pan step: move base pan, then back to P_REPEAT
+#define P_HOVER (9)       // HV_...: HoVer orientation of the shots that follow
+
+// P_HOVER operands
+#define HV_USER (0)       // the user's
+#define HV_HOR (1)
+#define HV_VERT (2)
+#define HV_OTHER (3)      // the other one from the user's
+
+// Shot offset, pan and tilt steps of -8 to 7, packed in a byte.
+// Shots are wrapped in pan and held within tilt's range of motion (addTilt()).
+#define OFF(pan, tilt) ((uint8_t)((((pan) & 0x0f) << 4) | ((tilt) & 0x0f)))
+#define OFF_PAN(off) ((int8_t)(off) >> 4)
+#define OFF_TILT(off) ((int8_t)((off) << 4) >> 4)
+
+// Signed operand
+#define STEP(n) ((uint8_t)(n))
+
+// Generates the aim points of one shoot sequence, one at a time, on demand.
+// The ShootController pulls from it to keep the shot queue topped up, so a
+// sequence can be any length without taking more RAM.
+//
+// Each shoot mode is a pattern: a short program in flash (see Sequence.cpp)
+// that moves a base aim point, starting at the user's, and lists shots as
+// offsets from it.  ShotSequence runs it one shot at a time.  Shots take the
+// user's HoVer orientation, unless the pattern sets another.  (A pattern can
+// also be run directly, as the host build's checks do.)
+class ShotSequence
+{
+  public:
+    ShotSequence();
+
+  private:
+    // Instance data
+    const uint8_t *pattern;   // the pattern, in PROGMEM
+    uint8_t pc;               // next pattern byte
+    uint8_t shots;            // offsets left in the current P_SHOTS list
+    uint8_t loopPc;           // start of the P_REPEAT loop
+    uint8_t loops;            // times left around it
+    PanTilt_t base;           // base aim point
+    bool userVert;            // the user's HoVer orientation
+    bool vert;                // HoVer orientation of the shots
+    unsigned count;           // shots in the sequence
+    unsigned n;               // next shot
+    uint8_t burst;            // frames to take at each shot
+
+  public:
+    // Public API
+    void start(Mode_t mode, const PanTilt_t *userPos, bool userVert);
+    void start(const uint8_t *pattern, uint8_t frames, const PanTilt_t *userPos, bool userVert);
+    unsigned remaining();
+    bool next(PanTilt_t *aimPoint, bool *vert);
+    uint8_t frames();
+
+  private:
+    // Utility methods
+    bool step(PanTilt_t *aimPoint);
+    uint8_t fetch();
+    int addPan(int pan, int step);
+    int addTilt(int tilt, int step);
+    int clampTilt(int tilt, int step);
+};
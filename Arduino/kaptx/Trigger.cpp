@@ -0,0 +1,177 @@
+#include "Trigger.h"
+#include "Ppm.h"
+#include "Tuning.h"
+
+#include <avr/interrupt.h>
+#include <Arduino.h>
+
+// ---------------------------------------------------------------------------------
+// Servo
+
+#if !defined(WIRED_SHUTTER_PIN) && !defined(IR_CANON)
+
+ServoTrigger::ServoTrigger(Ppm *_ppm, int _chan)
+{
+    ppm = _ppm;
+    chan = _chan;
+}
+
+// The PPM channel's servo is set up with the rest.
+void ServoTrigger::setup()
+{
+}
+
+void ServoTrigger::write(uint8_t pos)
+{
+    int pwm = SHUTTER_UP_PWM;
+
+    if (pos == TRIGGER_DOWN) pwm = SHUTTER_DOWN_PWM;
+#ifdef SHUTTER_HALF_PWM
+    else if (pos == TRIGGER_HALF) pwm = SHUTTER_HALF_PWM;
+#endif
+    ppm->write(chan, pwm);
+}
+
+uint8_t ServoTrigger::pressTicks()
+{
+    return TIME_SHUTTER_DOWN;
+}
+
+bool ServoTrigger::canHalfPress()
+{
+#ifdef SHUTTER_HALF_PWM
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif
+
+// ---------------------------------------------------------------------------------
+// Wired remote.  The focus line is held with the shutter line, as a remote's
+// button does.
+
+#ifdef WIRED_SHUTTER_PIN
+
+void WiredTrigger::setup()
+{
+    pinMode(WIRED_FOCUS_PIN, OUTPUT);
+    pinMode(WIRED_SHUTTER_PIN, OUTPUT);
+    write(TRIGGER_UP);
+}
+
+void WiredTrigger::write(uint8_t pos)
+{
+    digitalWrite(WIRED_FOCUS_PIN, (pos != TRIGGER_UP) ? HIGH : LOW);
+    digitalWrite(WIRED_SHUTTER_PIN, (pos == TRIGGER_DOWN) ? HIGH : LOW);
+}
+
+uint8_t WiredTrigger::pressTicks()
+{
+    return TIME_WIRED_DOWN;
+}
+
+bool WiredTrigger::canHalfPress()
+{
+    return true;
+}
+
+#endif
+
+// ---------------------------------------------------------------------------------
+// IR remote.  Timer2 runs in CTC mode and toggles OC2B (pin 3) at each compare
+// match, for the carrier.  Its compare A interrupt counts the matches, and turns
+// the carrier on and off by connecting OC2B to the pin or not.  That is ~540
+// short interrupts per code, all within 8mS of the shutter going down.
+
+#ifdef IR_CANON
+
+#define IR_TOP (244)           // at clock/1: 65.3kHz of matches, a 32.65kHz carrier
+
+// Compare matches in a time.  [microseconds]
+#define IR_MATCHES(us) (((us) * (F_CPU / 1000000) + (IR_TOP + 1) / 2) / (IR_TOP + 1))
+
+// Values for Timer2 config registers
+#define WGM2_CTC_A (0x02)          // CTC, OCR2A is TOP
+#define COM2B_01 (0x01 << 4)       // toggle OC2B on compare match
+#define CS2_DIV1 (0x01)
+#define TIMSK2_OCIEA (0x02)
+#define TIFR2_OCFA (0x02)
+
+// Canon RC-1, release at once: 16 cycles of carrier, 7.33mS off, 16 cycles.
+// (5.36mS off would be the 2 second delay.)  Phases are counted in compare
+// matches, two per carrier cycle.  The carrier only starts at the match after
+// an off phase ends, so that phase is one match short.
+static const uint16_t irPhases[] = { 32, IR_MATCHES(7330) - 1, 32 };
+#define IR_PHASES (sizeof(irPhases) / sizeof(irPhases[0]))
+
+struct IrOut_s {
+    volatile bool busy;    // a code is going out
+    uint8_t phase;
+    uint16_t count;        // compare matches left in the phase
+} _irOut;
+
+ISR(TIMER2_COMPA_vect)
+{
+    if (--_irOut.count) return;
+
+    if (++_irOut.phase == IR_PHASES) {
+	// code sent: stop the timer
+	TCCR2B = 0;
+	TIMSK2 = 0;
+	TCCR2A = WGM2_CTC_A;
+	_irOut.busy = false;
+	return;
+    }
+    _irOut.count = irPhases[_irOut.phase];
+    TCCR2A ^= COM2B_01;    // carrier on or off
+}
+
+IrTrigger::IrTrigger()
+{
+    last = TRIGGER_UP;
+}
+
+void IrTrigger::setup()
+{
+    pinMode(IR_PIN, OUTPUT);
+    digitalWrite(IR_PIN, LOW);
+
+    TCCR2B = 0;
+    TCCR2A = WGM2_CTC_A;
+    OCR2A = IR_TOP;
+    OCR2B = IR_TOP;
+    TIMSK2 = 0;
+    _irOut.busy = false;
+}
+
+// Send the code as the shutter goes down.
+void IrTrigger::write(uint8_t pos)
+{
+    if ((pos == TRIGGER_DOWN) && (last != TRIGGER_DOWN) && !_irOut.busy) {
+	_irOut.busy = true;
+	_irOut.phase = 0;
+	_irOut.count = irPhases[0];
+
+	TCNT2 = 0;
+	TCCR2A = WGM2_CTC_A | COM2B_01;
+	TIFR2 = TIFR2_OCFA;
+	TIMSK2 = TIMSK2_OCIEA;
+	TCCR2B = CS2_DIV1;
+    }
+    last = pos;
+}
+
+// The code takes 8mS; one frame covers it.
+uint8_t IrTrigger::pressTicks()
+{
+    return 1;
+}
+
+bool IrTrigger::canHalfPress()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Tuning.h"
+
+class Ppm;
+
+// Shutter positions
+#define TRIGGER_UP (0)
+#define TRIGGER_HALF (1)     // half pressed: the camera focuses
+#define TRIGGER_DOWN (2)
+
+// How the shutter gets pressed.  ShutterController decides when; the sketch
+// writes the shutter position to the trigger every frame, and the trigger turns
+// it into a signal to the camera.  Tuning.h chooses the backend, and only that
+// one is built: Trigger is its class.  Each has the same methods:
+//   setup()          set up the pins and timers
+//   write(pos)       the shutter position, TRIGGER_UP to TRIGGER_DOWN
+//   pressTicks()     ticks to hold the shutter down
+//   canHalfPress()   whether TRIGGER_HALF focuses the camera
+
+#if defined(WIRED_SHUTTER_PIN) && defined(IR_CANON)
+#error Define either WIRED_SHUTTER_PIN or IR_CANON, not both
+#endif
+
+#if defined(WIRED_SHUTTER_PIN)
+
+// The camera's wired remote socket: a focus and a shutter line, each switched
+// by an opto or transistor from a pin.
+class WiredTrigger
+{
+  public:
+    void setup();
+    void write(uint8_t pos);
+    uint8_t pressTicks();
+    bool canHalfPress();
+};
+typedef WiredTrigger Trigger;
+
+#elif defined(IR_CANON)
+
+// An IR LED sending the Canon RC-1 remote's shutter code, on the carrier Timer2
+// makes.  The code goes out once as the shutter goes down.
+#define IR_PIN (3)     // OC2B, so fixed
+class IrTrigger
+{
+  public:
+    IrTrigger();
+
+    void setup();
+    void write(uint8_t pos);
+    uint8_t pressTicks();
+    bool canHalfPress();
+
+  private:
+    uint8_t last;          // position last written
+};
+typedef IrTrigger Trigger;
+
+#else
+
+// A servo on a PPM channel presses the shutter button.
+class ServoTrigger
+{
+  public:
+    ServoTrigger(Ppm *_ppm, int _chan);
+
+    void setup();
+    void write(uint8_t pos);
+    uint8_t pressTicks();
+    bool canHalfPress();
+
+  private:
+    Ppm *ppm;
+    int chan;
+};
+typedef ServoTrigger Trigger;
+
+#endif
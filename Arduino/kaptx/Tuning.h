@@ -51,7 +51,27 @@
 #define SHUTTER_DOWN_PWM (600)  // +300uS from center
 #define SHUTTER_UP_PWM (-600)   // -300uS from center
 
-// HoVer (Portrait/Landscape) servo positions
+// Shutter half press position, for a shutter servo (or remote) that can half press.
+// The camera then focuses while the rig is still settling, and the shutter goes
+// down as soon as the rig is stable.  Uncomment to use it.
+// #define SHUTTER_HALF_PWM (0)    // center
+
+// Electronic shutter trigger.  With neither of these, the shutter servo on PPM
+// channel 3 presses the shutter.  A trigger needs no servo travel and a shorter
+// press, so each shot takes 100mS or more less.  Uncomment one to use it instead.
+//
+// Wired remote: an opto (or transistor) from each pin shorts a line of the camera's
+// remote socket to ground while the pin is HIGH.  The focus line half presses.
+// #define WIRED_FOCUS_PIN (7)
+// #define WIRED_SHUTTER_PIN (2)
+#define TIME_WIRED_DOWN FRAMES_MS(60)   // [ticks]
+//
+// IR remote: an IR LED (and its resistor) on pin 3 sends the Canon RC-1 remote's code.
+// This uses Timer2.  Set the camera to take remote control shots.
+// #define IR_CANON
+
+// HoVer (Portrait/Landscape) servo positions.  The HoVer servo is slewed like pan and
+// tilt (see ACCEL_HOVER), and a shot waits for it to settle too.
 #define HOVER_HOR_PWM (600)     // +300uS from center
 #define HOVER_VERT_PWM (-600)   // -300uS from center
 
@@ -67,20 +87,142 @@
 #define JS_DIR_X (1)  // (-1) if X direction should be reversed
 #define JS_DIR_Y (1)  // (-1) if Y direction should be reversed
 
+// ----------------------------------------------------------------------------------------
+// PPM output options
+
+// Number of channels in each PPM frame, 4 to 8, as PPM_FRAME_US allows.
+// Pan, tilt, shutter and HoVer use channels 1-4.
+#define PPM_CHANNELS (6)
+
+// Length of one PPM frame, 20000 (the standard 50Hz frame) or less.  [microseconds]
+// It must hold every channel at full throw (2300uS) and the sync gap:
+// PPM_CHANNELS * 2300 + PPM_SYNC_MIN_US at least.  With a 3000uS gap, that is
+// 16800 for 6 channels and 12200 for 4; 20000 holds up to 7.  (Ppm.cpp checks.)
+// A shorter frame reduces the delay from controller to servo, if your receiver
+// accepts it.
+#define PPM_FRAME_US (20000)
+
+// Shortest sync gap your receiver will accept.  [microseconds]
+#define PPM_SYNC_MIN_US (3000)
+
 // ----------------------------------------------------------------------------------------
 // Timing parameters for movement and shootint cycles
 
-// All of the following timing values are in units of 50Hz ticks.
-// That is, a value of 1 represents 20ms.  50 represents 1 second.
+// All of the following timing values are in units of PPM frames (ticks).
+// With the standard 50Hz frame, a value of 1 represents 20ms.  50 represents 1 second.
+// FRAMES_MS() converts milliseconds to the nearest number of frames.
+#define FRAMES_MS(ms) ((((long)(ms)) * 1000 + PPM_FRAME_US/2) / PPM_FRAME_US)
+
+// The servo rates below are per 20mS (one standard frame), whatever PPM_FRAME_US is.
+
+// Pan and tilt servo acceleration.  [PWM units per 20mS per 20mS]
+// A move accelerates at this rate up to its top speed, then slows down to stop on target.
+// These may be fractional, to 1/256: heavy rigs may want less than 1, 0.6 say.
+#define ACCEL_PAN (1.0)
+#define ACCEL_TILT (1.0)
+
+// Pan and tilt servo top speed.  [PWM units per 20mS]
+// Keep these within what the servos can actually do, or they lag behind the slew.
+// The axis with the shorter move is slowed further, so both arrive together.
+// (Fractional values are allowed here as well, up to 127.)
+#define VMAX_PAN (40)
+#define VMAX_TILT (40)
+
+// HoVer servo acceleration and top speed, as for pan and tilt.  A HoVer turn is
+// planned with the pan and tilt move, and all three arrive together.
+#define ACCEL_HOVER (2.0)
+#define VMAX_HOVER (60)
+
+// Pan, tilt and HoVer jerk limit, to ease each move in and out rather than switch the
+// acceleration on and off, which sets a hanging rig swinging.  [PWM units per 20mS^3]
+// Each move is smoothed over 2 * ACCEL / JERK times 20mS (16 ticks at most), and
+// takes that much longer; it should need less TIME_STABILIZING_MAX.
+// Uncomment to use it on that axis; otherwise acceleration is constant.
+// #define JERK_PAN (0.25)
+// #define JERK_TILT (0.25)
+// #define JERK_HOVER (0.5)
 
-// Time between servo stops moving taking a photo.  [50Hz ticks]
-#define TIME_STABILIZING (10)  // 0.2 S
+// Time between servo stops moving taking a photo.  [ticks]
+// Big, fast moves set the rig swinging more than small ones, so this scales with
+// the move: from TIME_STABILIZING_MIN after the least move up to TIME_STABILIZING_MAX
+// after one of STABILIZING_FULL_PWM, or one that reached STABILIZING_FULL_VEL,
+// whichever comes nearer.  (Set MIN and MAX the same for a fixed time.)
+#define TIME_STABILIZING_MIN FRAMES_MS(60)
+#define TIME_STABILIZING_MAX FRAMES_MS(300)
+#define STABILIZING_FULL_PWM (1600)   // [PWM units]  About 180 degrees of pan.
+#define STABILIZING_FULL_VEL (40)     // [PWM units per 20mS]
 
 // Time shutter servo stays pressed.
-#define TIME_SHUTTER_DOWN (5)  // 100ms, fast enough to trigger GentLED
+#define TIME_SHUTTER_DOWN FRAMES_MS(100)  // fast enough to trigger GentLED
+
+// If the shutter can half press (SHUTTER_HALF_PWM, or a wired remote), how long before
+// the rig is due to be stable to half press.
+// Allow the time your camera takes to focus.
+#define TIME_SHUTTER_HALF_LEAD FRAMES_MS(500)
 
 // Time after releasing shutter before servos are allowed to move again.
 // This is time required for the camera to focus and shoot.
-#define TIME_SHUTTER_POST (35) // 700ms, Needs to be longer if autofocus used on EOS M.
+#define TIME_SHUTTER_POST FRAMES_MS(700)  // Needs to be longer if autofocus used on EOS M.
+
+// Camera feedback.  If the camera gives a signal when it has finished a frame (a card
+// busy LED, say, through an opto to ground: the pin goes HIGH as the LED goes out),
+// wire it to CAMERA_PIN.  Once the exposure
+// is over (TIME_SHUTTER_EXPOSED, below), the shutter is ready again as soon as the
+// signal comes, and TIME_SHUTTER_POST is only a timeout.  The signal shortens
+// nothing unless TIME_SHUTTER_EXPOSED is set below TIME_SHUTTER_POST: by default
+// they are the same.
+// The pin has a pullup, so with nothing connected the timeout always applies.
+// Send 'c' on the serial monitor for the times the camera is taking.
+// Uncomment CAMERA_PIN to use it.  (It takes the pin change interrupt of port B.)
+// #define CAMERA_PIN (8)     // Port B: 8 to 13
+#define CAMERA_ACTIVE (HIGH)  // level the pin goes to when the camera is done
+
+// Time after releasing shutter until the exposure is surely over.  The servos start
+// for the next shot then, while the camera is still writing out; the shutter waits
+// out the rest of TIME_SHUTTER_POST.  As TIME_SHUTTER_POST, the rig holds still
+// throughout.  To start the next slew early, set it lower, FRAMES_MS(250) say,
+// allowing for your slowest shutter speed, and for autofocus if used.
+#define TIME_SHUTTER_EXPOSED TIME_SHUTTER_POST
+
+// Frames to take at each aim point, per shoot mode, 1 to 8.  The shutter is pressed
+// again TIME_BURST_GAP after each frame, without moving the rig or waiting for it to
+// settle again.  For HDR, set the camera to bracket and this to the bracket's frames.
+#define BURST_SINGLE (1)
+#define BURST_CLUSTER (1)
+#define BURST_VPAN (1)
+#define BURST_HPAN (1)
+#define BURST_QUAD (1)
+#define BURST_360 (1)
+
+// Time from releasing the shutter to pressing it for the next frame of a burst.  [ticks]
+// Allow for your slowest bracketed shutter speed.
+#define TIME_BURST_GAP FRAMES_MS(200)
+
+// ----------------------------------------------------------------------------------------
+// Shot planning
+
+// Reorder the shots of each shoot sequence to cut the time spent slewing between
+// them.  (The first shot is left first.)  Comment out to shoot in pattern order.
+#define PLAN_SHOTS
+
+// Most move times the planner works out in a frame.  Each is at most about 6000 CPU
+// cycles on a 16MHz AVR: three moving axes, each a long divide (about 700) and a
+// square root (about 800), and the pan wrap search.  So 12 is at most about 72000
+// cycles, 4.5mS: it fits in what is left of the busiest frames, which redraw the
+// LCD in up to about 12mS (kaptx_sim -s).
+#define PLAN_EVALS_FRAME (12)
+
+// Most move times the planner works out in one run, counting all of its stages.
+// A full queue of 32 shots takes about 800, and 2-opt gets the rest: so 2000 plans
+// it in under 170 frames.  With less, the last shots keep their order, and take
+// the nearest pan wrap.
+#define PLAN_EVALS (2000)
+
+// ----------------------------------------------------------------------------------------
+// Debug options
+
+// Uncomment to time each stage of loop().  Send 'p' on the serial monitor for a report.
+// Costs about 350 bytes of RAM.
+// #define LOOP_PROFILE
 
 #endif
@@ -827,7 +827,7 @@ void View::drawUpdates(unsigned char flags)
 	showShootMode(model->getShootModeDisp(), !!(flags & INV_SHOOT_MODE));
     }
     if (flags & REFRESH_AUTO_COUNT) {
-	showShots(model->getAuto(), model->getShotsQueued(), !!(flags & INV_AUTO_COUNT));
+	showShots(model->getAuto(), model->getShotsRemaining(), !!(flags & INV_AUTO_COUNT));
     }
 }
 
@@ -5,18 +5,14 @@
 
 #include "Ppm.h"
 #include "Joystick.h"
+#include "Camera.h"
+#include "Trigger.h"
 #include "View.h"
 #include "Model.h"
 #include "Controller.h"
+#include "Profile.h"
 #include "Tuning.h"
 
-// Create components from libraries
-Ppm ppm;
-Joystick js;
-Model model;                                 // model
-View view(&model);         // view 
-Controller controller(&js, &model);                     // controller
-
 // ----------------------------------------------------------------------------------------------
 // PPM for KAP
 
@@ -27,7 +23,61 @@ Controller controller(&js, &model);                     // controller
 #define CHAN_5_UNUSED (5)
 #define CHAN_6_UNUSED (6)
 
+// Create components from libraries
+Ppm ppm;
+Joystick js;
+Camera camera;
+#if defined(WIRED_SHUTTER_PIN)
+WiredTrigger trigger;
+#elif defined(IR_CANON)
+IrTrigger trigger;
+#else
+ServoTrigger trigger(&ppm, CHAN_SHUTTER);
+#endif
+Model model;                                 // model
+View view(&model);         // view 
+Controller controller(&js, &camera, &trigger, &model);            // controller
+
+#ifdef LOOP_PROFILE
+Profile prof(&ppm);
+#define PROFILE(stage) prof.mark(stage)
+#else
+#define PROFILE(stage)
+#endif
+
 // ---------------------------------------------------------------------
+// Single character debug commands from the serial monitor
+//   s : print frame slack statistics
+//   p : print loop profile (if LOOP_PROFILE is defined)
+//   c : print camera feedback times
+void serialCommand()
+{
+    if (!Serial.available()) return;
+
+    switch (Serial.read()) {
+	case 's':
+	    ppm.printSlack();
+	    break;
+	case 'c':
+	    camera.printStats();
+	    break;
+#ifdef LOOP_PROFILE
+	case 'p':
+	    prof.print();
+	    break;
+#endif
+	default:
+	    break;
+    }
+}
+
+// Shutter position, for the trigger
+uint8_t shutterPos()
+{
+    if (model.getShutter()) return TRIGGER_DOWN;
+    if (model.getShutterHalf()) return TRIGGER_HALF;
+    return TRIGGER_UP;
+}
 
 void setup()
 {
@@ -35,6 +85,8 @@ void setup()
     Serial.println(F("Hello!"));
 
     js.setup();
+    camera.setup();
+    trigger.setup();
     ppm.setup();
     view.setup();
 }
@@ -42,25 +94,42 @@ void setup()
 void loop()
 {
     // Wait for PPM cycle to start (50Hz)
-    ppm.sync();	
+    uint16_t tick = ppm.sync();
+    PROFILE(PROF_SYNC);
 
     // read inputs
-    js.poll();
+    js.poll(tick);
+    camera.poll();
+    PROFILE(PROF_POLL);
 
     // Let controller do it's thing.
-    controller.update();
+    controller.update(tick);
+    PROFILE(PROF_CONTROL);
 
     // update PPM outputs
     struct PanTilt_s pos;
     ppm.write(CHAN_PAN, model.getPanPwm());
+    PROFILE(PROF_WRITE_PAN);
     ppm.write(CHAN_TILT, model.getTiltPwm());
-    ppm.write(CHAN_SHUTTER, model.getShutter() ? SHUTTER_DOWN_PWM : SHUTTER_UP_PWM);
-    ppm.write(CHAN_HOVER, model.getHoVer() ? HOVER_VERT_PWM : HOVER_HOR_PWM);
+    PROFILE(PROF_WRITE_TILT);
+    trigger.write(shutterPos());
+    PROFILE(PROF_WRITE_SHUTTER);
+    ppm.write(CHAN_HOVER, model.getHoVerPwm());
+    PROFILE(PROF_WRITE_HOVER);
 
     // repeat tilt on channel 6 just to test that channel
     ppm.write(CHAN_6_UNUSED, model.getTiltPwm());
+    PROFILE(PROF_WRITE_6);
 
+    // send all channels as one frame
+    ppm.commit();
+    PROFILE(PROF_COMMIT);
 
     // update LCD
     view.update();
+    PROFILE(PROF_VIEW);
+
+    // handle debug requests
+    serialCommand();
 }
+